@@ -1,17 +1,22 @@
 #include "algos.h"
 #include "rand.h"
-#include <QDebug>
+#include "metrics.h"
+#include "parallel.h"
+#include <cassert>
 #include <cmath>
+#include <iostream>
 
 #define DEBUG_OUTPUT 0
 
-qreal mse(v<pr<qreal, qreal>> const& points, qreal const k, qreal const b) noexcept {
-    auto f = [&k, &b](qreal const x) {
+double mse(v<pr<double, double>> const& points, double const k, double const b) noexcept {
+    auto f = [&k, &b](double const x) {
         return k * x + b;
     };
 
-    qreal result = 0, diff;
+    double result = 0, diff;
 
+    METRICS_COUNT("loss_evaluations", 1);
+    METRICS_COUNT("samples_touched", points.size());
     for (auto const& elem : points) {
         diff = elem.second - f(elem.first);
         result += diff * diff;
@@ -19,45 +24,47 @@ qreal mse(v<pr<qreal, qreal>> const& points, qreal const k, qreal const b) noexc
     return result / points.size();
 }
 
-v<int> rand_seq(int const k, int const n)
+pr<double, double> least_squares(way_t const& points) noexcept
 {
-    assert(k <= n && k >= 0);
-    v<int> elem(n), result;
-    int temp;
-    result.reserve(k);
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    double const n = points.size();
 
-    for (int i = 0; i < n; ++i) {
-        elem[i] = i;
-    }
-
-    for (int i = 0; i < k; ++i) {
-        temp = random(0, static_cast<int>(elem.size()) - 1);
-        result.push_back(elem[temp]);
-        elem[temp] = elem.back();
-        elem.pop_back();
+    for (auto const& elem : points) {
+        sx += elem.first;
+        sy += elem.second;
+        sxx += elem.first * elem.first;
+        sxy += elem.first * elem.second;
     }
 
-    return result;
+    double const k = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return {k, (sy - k * sx) / n};
 }
 
-std::tuple<qreal, qreal, int> linear_regression(const way_t &points, const int batch, const qreal lrk, const qreal lrb, const qreal k, const qreal b, const int max_step, const qreal dlt)
+std::tuple<double, double, int> linear_regression(const way_t &points, const int batch, const double lrk, const double lrb, const double k, const double b, const int max_step, const double dlt)
 {
-    assert(batch > 0 && batch <= points.size());
-    qreal optimal_sse = mse(points, k, b);
-    pr<qreal, qreal> cur = {0, 0};
-    qreal cur_mse;
+    assert(batch > 0 && batch <= static_cast<int>(points.size()));
+    double optimal_sse = mse(points, k, b);
+    pr<double, double> cur = {0, 0};
+    double cur_mse;
+    // the whole run is replayed by this seed
+    uint64_t const seed = thread_rng()();
 
     for (int i = 1; i <= max_step; ++i) {
-        cur = step(points, cur.first, cur.second, lrk, lrb, batch);
+        METRICS_COUNT("steps", 1);
+        cur = step(points, cur.first, cur.second, lrk, lrb, batch, seed, i);
         if (std::isnan(cur.first) || std::isnan(cur.second)) {
             return {cur.first, cur.second, i};
         }
 #if DEBUG_OUTPUT
         if (i % 10 == 0) {
-            qDebug() << cur.first << cur.second;
+            std::cerr << cur.first << ' ' << cur.second << '\n';
         }
 #endif
-        cur_mse = mse(points, cur.first, cur.second);
+        {
+            METRICS_SCOPE("batch.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
 
         if (std::abs(optimal_sse - cur_mse) < dlt) {
             return {cur.first, cur.second, i};
@@ -67,43 +74,78 @@ std::tuple<qreal, qreal, int> linear_regression(const way_t &points, const int b
     return {cur.first, cur.second, max_step};
 }
 
-pr<qreal, qreal> step(const way_t &points, qreal const k, qreal const b, qreal const ck, qreal const cb, int const batch) {
-    auto chosen_index = rand_seq(batch, points.size());
-
-    qreal gradk = 0;
-    qreal gradb = 0;
-    qreal temp;
+pr<double, double> step(
+    const way_t &points,
+    double const k,
+    double const b,
+    double const ck,
+    double const cb,
+    int const batch,
+    uint64_t const seed,
+    uint32_t const step_index,
+    unsigned const threads)
+{
+    // fixed chunking keeps the summation order independent of the number of threads
+    size_t const chunk = 4096;
+    size_t const chunks = (batch + chunk - 1) / chunk;
+    size_t const n = points.size();
+    v<pr<double, double>> partial(chunks, {0, 0});
+    METRICS_COUNT("allocations", chunks > 0);
+
+    {
+        METRICS_SCOPE("batch.gradient");
+        METRICS_COUNT("samples_touched", batch);
+        parallel_for(chunks, [&](size_t const c) {
+            double gradk = 0;
+            double gradb = 0;
+            size_t const end = std::min<size_t>(batch, (c + 1) * chunk);
+            for (size_t j = c * chunk; j < end; ++j) {
+                // the 32-bit draw is cheaper and covers any dataset up to 2^32 points
+                auto const& elem = points[n <= UINT32_MAX ? philox_bounded(seed, step_index, j, static_cast<uint32_t>(n))
+                                                          : philox_bounded64(seed, step_index, j, n)];
+                double const temp = elem.second - (elem.first * k) - b;
+                gradk += (-2. / n) * temp * elem.first;
+                gradb += (-2. / n) * temp;
+            }
+            partial[c] = {gradk, gradb};
+        }, threads);
+    }
 
-    for (auto const& elem : chosen_index) {
-        temp = points[elem].second - (points[elem].first * k) - b;
-        gradk += (-2. / points.size()) * temp * points[elem].first;
-        gradb += (-2. / points.size()) * temp;
+    double gradk = 0;
+    double gradb = 0;
+    for (auto const& elem : partial) {
+        gradk += elem.first;
+        gradb += elem.second;
     }
+    METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
 
     return {k - ck * gradk, b - cb * gradb};
 }
 
-std::tuple<qreal, qreal, int> sdg_linear_regression(
+std::tuple<double, double, int> sdg_linear_regression(
     const way_t &points,
-    const qreal lrk,
-    const qreal lrb,
-    const qreal k,
-    const qreal b,
+    const double lrk,
+    const double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt)
+    const double dlt)
 {
-    qreal mse_bs = mse(points, k, b);
-    qreal cur_mse = 0;
-    qreal const coef = 2. / (points.size() + 1);
-    pr<qreal, qreal> cur = {0, 0};
-    qreal diff;
-    auto f = [&cur](qreal const x) {
+    double mse_bs = mse(points, k, b);
+    double cur_mse = 0;
+    double const coef = 2. / (points.size() + 1);
+    pr<double, double> cur = {0, 0};
+    double diff;
+    auto f = [&cur](double const x) {
         return cur.first * x + cur.second;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
     for (int i = 0; i < max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("sgd.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         diff = y(i) - f(x(i));
         cur.first -= lrk  * (-2.) * diff * x(i);
         cur.second -= lrb  * (-2.) * diff;
@@ -111,10 +153,11 @@ std::tuple<qreal, qreal, int> sdg_linear_regression(
 
         mse_bs = coef * diff + (1 - coef) * mse_bs;
         cur_mse = coef * diff + (1 - coef) * cur_mse;
+        METRICS_GAUGE("loss", cur_mse);
 
 #if DEBUG_OUTPUT
         if (i % 100 == 0) {
-            qDebug() << mse_bs << cur_mse << std::abs(mse_bs - cur_mse);
+            std::cerr << mse_bs << ' ' << cur_mse << ' ' << std::abs(mse_bs - cur_mse) << '\n';
         }
 #endif
 
@@ -125,47 +168,59 @@ std::tuple<qreal, qreal, int> sdg_linear_regression(
     return {cur.first, cur.second, max_step};
 }
 
-v<QCPCurveData> momentum_linear_regression(
+v<way_point> momentum_linear_regression(
     const way_t &points,
-    const qreal lrk,
-    const qreal lrb,
-    const qreal k,
-    const qreal b,
+    const double lrk,
+    const double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt)
+    const double dlt,
+    way_observer const& observer)
 {
-    qreal const m_force = 0.5;
-    qreal const optimal_mse = mse(points, k, b);
+    double const m_force = 0.5;
+    double const optimal_mse = mse(points, k, b);
 
-    qreal b_force = 0;
-    qreal cur_mse;
-    qreal diff;
-    qreal k_force = 0;
-    qreal gradk;
-    qreal gradb;
+    double b_force = 0;
+    double cur_mse;
+    double diff;
+    double k_force = 0;
+    double gradk;
+    double gradb;
 
-    pr<qreal, qreal> cur = {0, 0};
+    pr<double, double> cur = {0, 0};
 
-    auto f = [&cur](qreal const x) {
+    auto f = [&cur](double const x) {
         return cur.first * x + cur.second;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
-    v<QCPCurveData> way = {{0, cur.first, cur.second}};
+    v<way_point> way = {{0, cur.first, cur.second}};
 
     for (int i = 1; i <= max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("momentum.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         diff = y(i) - f(x(i));
         gradk = -2. * diff * x(i);
         gradb = -2. * diff;
+        METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
         k_force = m_force * k_force - lrk * gradk;
         b_force = m_force * b_force - lrb * gradb;
         cur.first += k_force;
         cur.second += b_force;
-
-        cur_mse = mse(points, cur.first, cur.second);
-
+        {
+            METRICS_SAMPLED_SCOPE("momentum.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
+        [[maybe_unused]] size_t const capacity = way.capacity();
         way.emplace_back(i, cur.first, cur.second);
+        METRICS_COUNT("allocations", way.capacity() != capacity);
+        if (observer && !observer(way.back())) {
+            break;
+        }
         if (std::abs(cur_mse - optimal_mse) < dlt) {
             break;
         }
@@ -173,36 +228,48 @@ v<QCPCurveData> momentum_linear_regression(
     return way;
 }
 
-v<QCPCurveData> nesterov_linear_regression(const way_t &points, const qreal lrk, const qreal lrb, const qreal k, const qreal b, const int max_step, const qreal dlt)
+v<way_point> nesterov_linear_regression(const way_t &points, const double lrk, const double lrb, const double k, const double b, const int max_step, const double dlt, way_observer const& observer)
 {
-    qreal const m_force = 0.6;
-    qreal const optimal_mse = mse(points, k, b);
+    double const m_force = 0.6;
+    double const optimal_mse = mse(points, k, b);
 
-    qreal cur_mse;
-    qreal b_force = 0;
-    qreal k_force = 0;
-    qreal gradk;
-    qreal gradb;
+    double cur_mse;
+    double b_force = 0;
+    double k_force = 0;
+    double gradk;
+    double gradb;
 
-    pr<qreal, qreal> cur = {0, 0};
-    auto f = [&cur, &lrk, &k_force, &lrb, &b_force](qreal const x) {
+    pr<double, double> cur = {0, 0};
+    auto f = [&cur, &lrk, &k_force, &lrb, &b_force](double const x) {
         return (cur.first - lrk * k_force) * x + cur.second - lrb * b_force;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
-    v<QCPCurveData> way = {{0, cur.first, cur.second}};
+    v<way_point> way = {{0, cur.first, cur.second}};
 
     for (int i = 0; i < max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("nesterov.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         gradk = -2. * (y(i) - f(x(i))) * x(i);
         gradb = -2. * (y(i) - f(x(i)));
+        METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
         k_force = m_force * k_force - lrk * gradk;
         b_force = m_force * b_force - lrb * gradb;
         cur.first += k_force;
         cur.second += b_force;
-
-        cur_mse = mse(points, cur.first, cur.second);
+        {
+            METRICS_SAMPLED_SCOPE("nesterov.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
+        [[maybe_unused]] size_t const capacity = way.capacity();
         way.emplace_back(i, cur.first, cur.second);
+        METRICS_COUNT("allocations", way.capacity() != capacity);
+        if (observer && !observer(way.back())) {
+            break;
+        }
         if (std::abs(cur_mse - optimal_mse) < dlt) {
             break;
         }
@@ -210,46 +277,58 @@ v<QCPCurveData> nesterov_linear_regression(const way_t &points, const qreal lrk,
     return way;
 }
 
-v<QCPCurveData> adagrad_linear_regression(
+v<way_point> adagrad_linear_regression(
     const way_t &points,
-    qreal lrk,
-    qreal lrb,
-    const qreal k,
-    const qreal b,
+    double lrk,
+    double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt)
+    const double dlt,
+    way_observer const& observer)
 {
-    qreal const optimal_mse = mse(points, k, b);
+    double const optimal_mse = mse(points, k, b);
     lrk *= 250;
     lrb *= 150;
-    qreal gk = 0;
-    qreal gb = 0;
-    qreal gradk;
-    qreal gradb;
-    qreal diff;
-    qreal cur_mse;
-
-    pr<qreal, qreal> cur = {0, 0};
-    auto f = [&cur](qreal const x) {
+    double gk = 0;
+    double gb = 0;
+    double gradk;
+    double gradb;
+    double diff;
+    double cur_mse;
+
+    pr<double, double> cur = {0, 0};
+    auto f = [&cur](double const x) {
         return cur.first * x + cur.second;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
-    v<QCPCurveData> way = {{-1, cur.first, cur.second}};
+    v<way_point> way = {{-1, cur.first, cur.second}};
 
     for (int i = 0; i < max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("adagrad.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         diff = y(i) - f(x(i));
         gradk = -2. * diff * x(i);
         gradb = -2. * diff;
+        METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
         gk += gradk * gradk;
         gb += gradb * gradb;
         cur.first -= (lrk / std::sqrt(gk + dlt)) * gradk;
         cur.second -= (lrb / std::sqrt(gb + dlt)) * gradb;
-
-        cur_mse = mse(points, cur.first, cur.second);
-
+        {
+            METRICS_SAMPLED_SCOPE("adagrad.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
+        [[maybe_unused]] size_t const capacity = way.capacity();
         way.emplace_back(i, cur.first, cur.second);
+        METRICS_COUNT("allocations", way.capacity() != capacity);
+        if (observer && !observer(way.back())) {
+            break;
+        }
         if (std::abs(cur_mse - optimal_mse) < dlt) {
             break;
         }
@@ -258,37 +337,49 @@ v<QCPCurveData> adagrad_linear_regression(
     return way;
 }
 
-v<QCPCurveData> rmsprop_linear_regression(const way_t &points, qreal const lrk, qreal const lrb, const qreal k, const qreal b, const int max_step, const qreal dlt)
+v<way_point> rmsprop_linear_regression(const way_t &points, double const lrk, double const lrb, const double k, const double b, const int max_step, const double dlt, way_observer const& observer)
 {
-    qreal const optimal_mse = mse(points, k, b);
-    qreal const pwr = 0.9;
-    qreal gk = 0;
-    qreal gb = 0;
-    qreal diff;
-    qreal gradk;
-    qreal gradb;
-    qreal cur_mse;
-
-    pr<qreal, qreal> cur = {0, 0};
-    auto f = [&cur](qreal const x) {
+    double const optimal_mse = mse(points, k, b);
+    double const pwr = 0.9;
+    double gk = 0;
+    double gb = 0;
+    double diff;
+    double gradk;
+    double gradb;
+    double cur_mse;
+
+    pr<double, double> cur = {0, 0};
+    auto f = [&cur](double const x) {
         return cur.first * x + cur.second;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
-    v<QCPCurveData> way = {{-1, cur.first, cur.second}};
+    v<way_point> way = {{-1, cur.first, cur.second}};
 
     for (int i = 0; i < max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("rmsprop.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         diff = y(i) - f(x(i));
         gradk = -2. * diff * x(i);
         gradb = -2. * diff;
+        METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
         gk = pwr * gk + (1 - pwr) * gradk * gradk;
         gb = pwr * gb + (1 - pwr) * gradb * gradb;
         cur.first -= (lrk / std::sqrt(gk + dlt))*gradk;
         cur.second -= (lrb / std::sqrt(gb + dlt))*gradb;
-        cur_mse = mse(points, cur.first, cur.second);
-
+        {
+            METRICS_SAMPLED_SCOPE("rmsprop.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
+        [[maybe_unused]] size_t const capacity = way.capacity();
         way.emplace_back(i, cur.first, cur.second);
+        METRICS_COUNT("allocations", way.capacity() != capacity);
+        if (observer && !observer(way.back())) {
+            break;
+        }
         if (std::abs(cur_mse - optimal_mse) < dlt) {
             break;
         }
@@ -296,33 +387,37 @@ v<QCPCurveData> rmsprop_linear_regression(const way_t &points, qreal const lrk,
     return way;
 }
 
-v<QCPCurveData> adam_linear_regression(const way_t &points, qreal const lrk, qreal const lrb, const qreal k, const qreal b, const int max_step, const qreal dlt)
+v<way_point> adam_linear_regression(const way_t &points, double const lrk, double const lrb, const double k, const double b, const int max_step, const double dlt, way_observer const& observer)
 {
-    qreal const optimal_mse = mse(points, k, b);
-    qreal const pwr1 = 0.9;
-    qreal const pwr2 = 0.98;
-    qreal p1k = 0;
-    qreal p1b = 0;
-    qreal p2k = 0;
-    qreal p2b = 0;
-    qreal diff;
-    qreal gradk;
-    qreal gradb;
-    qreal cur_mse;
-
-    pr<qreal, qreal> cur = {0, 0};
-    auto f = [&cur](qreal const x) {
+    double const optimal_mse = mse(points, k, b);
+    double const pwr1 = 0.9;
+    double const pwr2 = 0.98;
+    double p1k = 0;
+    double p1b = 0;
+    double p2k = 0;
+    double p2b = 0;
+    double diff;
+    double gradk;
+    double gradb;
+    double cur_mse;
+
+    pr<double, double> cur = {0, 0};
+    auto f = [&cur](double const x) {
         return cur.first * x + cur.second;
     };
     auto x = [&points](int const i) { return points[i % points.size()].first;};
     auto y = [&points](int const i) { return points[i % points.size()].second;};
 
-    v<QCPCurveData> way = {{0, cur.first, cur.second}};
+    v<way_point> way = {{0, cur.first, cur.second}};
 
     for (int i = 1; i < max_step; ++i) {
+        METRICS_SAMPLED_SCOPE("adam.step");
+        METRICS_COUNT("steps", 1);
+        METRICS_COUNT("samples_touched", 1);
         diff = y(i) - f(x(i));
         gradk = -2. * diff * x(i);
         gradb = -2. * diff;
+        METRICS_GAUGE("gradient_norm", std::hypot(gradk, gradb));
         p1k = pwr1 * p1k + (1 - pwr1) * gradk;
         p1b = pwr1 * p1b + (1 - pwr1) * gradb;
         p2k = pwr2 * p2k + (1 - pwr2) * gradk * gradk;
@@ -333,9 +428,17 @@ v<QCPCurveData> adam_linear_regression(const way_t &points, qreal const lrk, qre
         p2b /= 1. - std::pow(pwr2, i);
         cur.first -= (lrk / std::sqrt(p2k + dlt))*gradk;
         cur.second -= (lrb / std::sqrt(p2b + dlt))*gradb;
-        cur_mse = mse(points, cur.first, cur.second);
-
+        {
+            METRICS_SAMPLED_SCOPE("adam.loss_check");
+            cur_mse = mse(points, cur.first, cur.second);
+        }
+        METRICS_GAUGE("loss", cur_mse);
+        [[maybe_unused]] size_t const capacity = way.capacity();
         way.emplace_back(i, cur.first, cur.second);
+        METRICS_COUNT("allocations", way.capacity() != capacity);
+        if (observer && !observer(way.back())) {
+            break;
+        }
         if (std::abs(cur_mse - optimal_mse) < dlt) {
             break;
         }
@@ -343,31 +446,19 @@ v<QCPCurveData> adam_linear_regression(const way_t &points, qreal const lrk, qre
     return way;
 }
 
-v<pr<qreal, qreal> > get_points_polynomial(int n, auto const& f, const qreal x_min, const qreal x_max, const qreal delta)
-{
-    v<pr<qreal, qreal>> points(n);
-
-    for (auto& elem : points) {
-        elem.first = random(x_min, x_max, 5);
-        elem.second = f(elem.first + random(-delta, delta, 5));
-    }
-
-    return points;
-}
-
 
-qreal poly_mse(const v<pr<qreal, qreal> > &points, const v<qreal> &params) noexcept
+double poly_mse(const v<pr<double, double> > &points, const v<double> &params) noexcept
 {
-    auto f = [&params](qreal const x) {
-        qreal result = 0;
+    auto f = [&params](double const x) {
+        double result = 0;
 
-        for (int i = 0; i < params.size(); ++i) {
+        for (size_t i = 0; i < params.size(); ++i) {
             result += params[i] * std::pow(x, i);
         }
         return result;
     };
 
-    qreal result = 0, diff;
+    double result = 0, diff;
 
     for (auto const& elem : points) {
         diff = elem.second - f(elem.first);
@@ -376,7 +467,7 @@ qreal poly_mse(const v<pr<qreal, qreal> > &points, const v<qreal> &params) noexc
     return result / points.size();
 }
 
-v<qreal> polynomial_regression(const way_t &points, const int degree, auto const& regulation)
+v<double> polynomial_regression(const way_t &points, const int degree, auto const& regulation)
 {
 
 }
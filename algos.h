@@ -1,105 +1,127 @@
 #ifndef ALGOS_H
 #define ALGOS_H
 
-#include <QtGlobal>
-#include <QVector>
-#include "qcustomplot.h"
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 template<typename K, typename V>
 using pr = std::pair<K, V>;
 
 template<typename T>
-using v = QVector<T>;
+using v = std::vector<T>;
 
-using way_t = v<pr<qreal, qreal>>;
+using way_t = v<pr<double, double>>;
 
-// random sequence generator of k elements from [0..n-1]
-v<int> rand_seq(int const k, int const n);
+// point of optimizer trajectory: step number and current {k, b}
+struct way_point {
+    way_point() = default;
+    way_point(double const t, double const k, double const b) : t(t), k(k), b(b) {}
 
-qreal mse(v<pr<qreal, qreal>> const& points, qreal const k, qreal const b) noexcept;
+    double t = 0;
+    double k = 0;
+    double b = 0;
+};
 
-qreal poly_mse(v<pr<qreal, qreal>> const& points, v<qreal> const& params) noexcept;
+// called from the optimizer with every new trajectory point; returning false stops it
+using way_observer = std::function<bool(way_point const&)>;
+
+double mse(v<pr<double, double>> const& points, double const k, double const b) noexcept;
+
+// closed-form least squares fit, return {k, b}
+pr<double, double> least_squares(way_t const& points) noexcept;
+
+double poly_mse(v<pr<double, double>> const& points, v<double> const& params) noexcept;
 
 // return {k, b, number_of_steps}
-std::tuple<qreal, qreal, int> linear_regression(
+std::tuple<double, double, int> linear_regression(
     way_t const& points,
     int const batch,
-    qreal const lrk,
-    qreal const lrb,
-    qreal const k,
-    qreal const b,
+    double const lrk,
+    double const lrb,
+    double const k,
+    double const b,
     const int max_step,
-    const qreal dlt
+    const double dlt
     );
 
-//return new {k, b}
-pr<qreal, qreal> step(
+//return new {k, b}; sample j is points[philox(seed, step_index, j)] (drawn with replacement),
+// so the result depends only on (seed, step_index); large batches are split across threads
+pr<double, double> step(
     const way_t &points,
-    qreal const k,
-    qreal const b,
-    qreal const lrk,
-    qreal const lrb,
-    int const batch);
+    double const k,
+    double const b,
+    double const lrk,
+    double const lrb,
+    int const batch,
+    uint64_t const seed,
+    uint32_t const step_index,
+    unsigned const threads = 0);
 
 // return {k, b, number_of_steps}
-std::tuple<qreal, qreal, int> sdg_linear_regression(
+std::tuple<double, double, int> sdg_linear_regression(
     way_t const& points,
-    qreal const lrk,
-    qreal const lrb,
-    qreal const k,
-    qreal const b,
+    double const lrk,
+    double const lrb,
+    double const k,
+    double const b,
     const int max_step,
-    const qreal dlt
+    const double dlt
     );
 
-v<QCPCurveData> momentum_linear_regression(
+v<way_point> momentum_linear_regression(
     const way_t &points,
-    const qreal lrk,
-    const qreal lrb,
-    const qreal k,
-    const qreal b,
+    const double lrk,
+    const double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt);
+    const double dlt,
+    way_observer const& observer = {});
 
-v<QCPCurveData> nesterov_linear_regression(
+v<way_point> nesterov_linear_regression(
     const way_t &points,
-    const qreal lrk,
-    const qreal lrb,
-    const qreal k,
-    const qreal b,
+    const double lrk,
+    const double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt);
+    const double dlt,
+    way_observer const& observer = {});
 
-v<QCPCurveData> adagrad_linear_regression(
+v<way_point> adagrad_linear_regression(
     const way_t &points,
-    qreal lrk,
-    qreal lrb,
-    const qreal k,
-    const qreal b,
+    double lrk,
+    double lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt);
+    const double dlt,
+    way_observer const& observer = {});
 
-v<QCPCurveData> rmsprop_linear_regression(
+v<way_point> rmsprop_linear_regression(
     const way_t &points,
-    qreal const lrk,
-    qreal const lrb,
-    const qreal k,
-    const qreal b,
+    double const lrk,
+    double const lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt);
+    const double dlt,
+    way_observer const& observer = {});
 
-v<QCPCurveData> adam_linear_regression(
+v<way_point> adam_linear_regression(
     const way_t &points,
-    qreal const lrk,
-    qreal const lrb,
-    const qreal k,
-    const qreal b,
+    double const lrk,
+    double const lrb,
+    const double k,
+    const double b,
     const int max_step,
-    const qreal dlt);
-
-v<pr<qreal, qreal>> get_points_polynomial(int n, auto const& f, qreal const x_min, qreal const x_max, qreal const delta);
+    const double dlt,
+    way_observer const& observer = {});
 
-v<qreal> polynomial_regression(
+v<double> polynomial_regression(
     const way_t &points,
     int const degree,
     auto const& regulation);
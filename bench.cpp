@@ -0,0 +1,140 @@
+#include "bench.h"
+#include "dataset.h"
+#include "rand.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+v<bench_dataset> bench_datasets()
+{
+    return {
+        {"base",         500,    1.,   5., 0.,    10., 2.,  0.,   0.,  1e-3, 1e-2},
+        {"steep",        500,    5.,  -2., 0.,    10., 2.,  0.,   0.,  1e-3, 1e-2},
+        {"flat noisy",   500,    0.1,  3., 0.,    10., 6.,  0.,   0.,  1e-3, 1e-2},
+        {"wide x",       500,    1.,   5., -50.,  50., 2.,  0.,   0.,  2e-5, 1e-2},
+        {"narrow x",     500,    1.,   5., 0.,    1.,  0.5, 0.,   0.,  1e-2, 1e-2},
+        {"outliers",     500,    1.,   5., 0.,    10., 2.,  0.05, 40., 1e-3, 1e-2},
+        {"small n",      20,     1.,   5., 0.,    10., 2.,  0.,   0.,  1e-3, 1e-2},
+        {"large n",      20000,  1.,   5., 0.,    10., 2.,  0.,   0.,  1e-3, 1e-2},
+    };
+}
+
+v<bench_optimizer> bench_optimizers()
+{
+    // wrapped to drop the trailing observer parameter
+    return {
+        {"Momentum", [](auto const&... args) { return momentum_linear_regression(args...); }},
+        {"Nesterov", [](auto const&... args) { return nesterov_linear_regression(args...); }},
+        {"AdaGrad", [](auto const&... args) { return adagrad_linear_regression(args...); }},
+        {"RMSProp", [](auto const&... args) { return rmsprop_linear_regression(args...); }},
+        {"Adam", [](auto const&... args) { return adam_linear_regression(args...); }},
+    };
+}
+
+way_t make_dataset(bench_dataset const& dataset)
+{
+    dataset_spec spec;
+    spec.coefs = {dataset.b, dataset.k};
+    spec.x_min = dataset.x_min;
+    spec.x_max = dataset.x_max;
+    spec.delta = dataset.delta;
+    spec.outliers = dataset.outliers;
+    spec.outlier_delta = dataset.outlier_delta;
+    spec.seed = thread_rng()();
+    return synthesize(dataset.n, spec);
+}
+
+v<bench_result> convergence_bench(
+    v<bench_dataset> const& datasets,
+    v<bench_optimizer> const& optimizers,
+    int const max_step,
+    qreal const rel_gap)
+{
+    v<bench_result> results;
+
+    for (auto const& dataset : datasets) {
+        auto const points = make_dataset(dataset);
+        auto const optimum = least_squares(points);
+        qreal const optimal_mse = mse(points, optimum.first, optimum.second);
+
+        for (auto const& optimizer : optimizers) {
+            auto started = std::chrono::high_resolution_clock::now();
+            auto way = optimizer.run(points, dataset.lrk, dataset.lrb, optimum.first, optimum.second,
+                                     max_step, rel_gap * optimal_mse);
+            auto done = std::chrono::high_resolution_clock::now();
+
+            bench_result result;
+            result.dataset = dataset.name;
+            result.optimizer = optimizer.name;
+            result.steps = way.size() - 1;
+            result.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(done - started).count();
+            result.gap.reserve(way.size());
+            for (auto const& elem : way) {
+                result.gap.push_back((mse(points, elem.k, elem.b) - optimal_mse) / optimal_mse);
+            }
+            result.reached = !result.gap.empty() && std::abs(result.gap.back()) < rel_gap;
+            results.push_back(std::move(result));
+        }
+    }
+    return results;
+}
+
+void print_bench_table(std::ostream& out, v<bench_result> const& results)
+{
+    out << std::left << std::setw(14) << "dataset" << std::setw(12) << "optimizer"
+        << std::right << std::setw(10) << "steps" << std::setw(14) << "time, us"
+        << std::setw(14) << "ns/step" << std::setw(10) << "reached" << '\n';
+
+    for (auto const& result : results) {
+        out << std::left << std::setw(14) << result.dataset.toStdString()
+            << std::setw(12) << result.optimizer.toStdString()
+            << std::right << std::setw(10) << result.steps
+            << std::setw(14) << std::fixed << std::setprecision(1) << result.ns / 1000.
+            << std::setw(14) << std::setprecision(1) << static_cast<qreal>(result.ns) / std::max(result.steps, 1)
+            << std::setw(10) << (result.reached ? "yes" : "no") << '\n';
+    }
+}
+
+void plot_convergence(QCustomPlot& plot, v<bench_result> const& results)
+{
+    static Qt::GlobalColor const colors[] = {Qt::red, Qt::blue, Qt::darkGreen, Qt::magenta, Qt::darkYellow, Qt::cyan};
+    QSharedPointer<QCPAxisTickerLog> ticker(new QCPAxisTickerLog);
+
+    plot.legend->setVisible(true);
+
+    QMap<QString, QCPAxisRect*> rects;
+    QMap<QString, int> color_index;
+
+    for (auto const& result : results) {
+        QCPAxisRect* rect = rects.value(result.dataset, nullptr);
+        if (rect == nullptr) {
+            if (rects.isEmpty()) {
+                rect = plot.axisRect();
+            } else {
+                rect = new QCPAxisRect(&plot);
+                plot.plotLayout()->addElement(rects.size(), 0, rect);
+            }
+            rect->axis(QCPAxis::atBottom)->setLabel("step");
+            rect->axis(QCPAxis::atLeft)->setLabel(result.dataset + ": (mse - opt) / opt");
+            rect->axis(QCPAxis::atLeft)->setScaleType(QCPAxis::stLogarithmic);
+            rect->axis(QCPAxis::atLeft)->setTicker(ticker);
+            rects[result.dataset] = rect;
+        }
+
+        QCPGraph* graph = plot.addGraph(rect->axis(QCPAxis::atBottom), rect->axis(QCPAxis::atLeft));
+        int& color = color_index[result.optimizer];
+        if (color == 0) {
+            color = color_index.size();
+        }
+        graph->setPen(QPen(QBrush(colors[(color - 1) % 6]), 1.5));
+        graph->setName(result.optimizer);
+        if (rects.size() > 1) {
+            graph->removeFromLegend();
+        }
+        for (size_t i = 0; i < result.gap.size(); ++i) {
+            graph->addData(i, std::abs(result.gap[i]));
+        }
+        graph->rescaleAxes();
+    }
+    plot.replot();
+}
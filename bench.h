@@ -0,0 +1,66 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <functional>
+#include <ostream>
+#include "algos.h"
+#include "qcustomplot.h"
+
+// synthetic dataset description: y = kx + b + noise, some points shifted by outlier_delta
+struct bench_dataset {
+    QString name;
+    int n;
+    qreal k;
+    qreal b;
+    qreal x_min;
+    qreal x_max;
+    qreal delta;
+    qreal outliers;
+    qreal outlier_delta;
+    qreal lrk;
+    qreal lrb;
+};
+
+using optimizer_t = std::function<v<way_point>(
+    way_t const& points,
+    qreal const lrk,
+    qreal const lrb,
+    qreal const k,
+    qreal const b,
+    int const max_step,
+    qreal const dlt)>;
+
+struct bench_optimizer {
+    QString name;
+    optimizer_t run;
+};
+
+struct bench_result {
+    QString dataset;
+    QString optimizer;
+    bool reached;
+    int steps;
+    qint64 ns;
+    // relative loss gap (mse - optimal) / optimal after every step
+    v<qreal> gap;
+};
+
+v<bench_dataset> bench_datasets();
+
+v<bench_optimizer> bench_optimizers();
+
+way_t make_dataset(bench_dataset const& dataset);
+
+// run every optimizer on every dataset until relative gap to closed-form optimum is below rel_gap
+v<bench_result> convergence_bench(
+    v<bench_dataset> const& datasets,
+    v<bench_optimizer> const& optimizers,
+    int const max_step,
+    qreal const rel_gap);
+
+void print_bench_table(std::ostream& out, v<bench_result> const& results);
+
+// one axis rect per dataset, gap over steps in log scale
+void plot_convergence(QCustomPlot& plot, v<bench_result> const& results);
+
+#endif // BENCH_H
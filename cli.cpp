@@ -0,0 +1,227 @@
+// headless runner: same optimizers as the GUI, no Qt at all
+#include "algos.h"
+#include "dataset.h"
+#include "metrics.h"
+#include "rand.h"
+#include "surface_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+struct options {
+    std::string input;
+    std::string output;
+    std::string metrics;
+    std::string surface;
+    std::string optimizer = "momentum";
+    int n = 500;
+    double k = 1;
+    double b = 5;
+    double x_min = 0;
+    double x_max = 10;
+    double delta = 2;
+    double lrk = 1e-3;
+    double lrb = 1e-2;
+    double dlt = 1e-3;
+    int max_step = 100000;
+    int batch = 1;
+    long long seed = -1;
+    int surface_size = 4096;
+    double k_min = -7.5;
+    double k_max = 7.5;
+    double b_min = -2.5;
+    double b_max = 12.5;
+    bool trajectory = true;
+};
+
+static void usage(std::ostream& out)
+{
+    out << "usage: lab2-cli [options]\n"
+           "  --input FILE       read points \"x y\" per line ('-' for stdin)\n"
+           "  --n N              generate N points on y = kx + b (default 500)\n"
+           "  --k K --b B        line of generated points (default 1 5)\n"
+           "  --x-min X --x-max X  x range of generated points (default 0 10)\n"
+           "  --delta D          noise of generated points (default 2)\n"
+           "  --optimizer NAME   momentum | nesterov | adagrad | rmsprop | adam | sgd | batch\n"
+           "  --lrk LR --lrb LR  learning rates (default 1e-3 1e-2)\n"
+           "  --dlt D            stop when |mse - optimal mse| < D (default 1e-3)\n"
+           "  --max-step N       step limit (default 100000)\n"
+           "  --batch N          batch size for 'batch' (default 1)\n"
+           "  --seed S           seed of the random generator (default: random)\n"
+           "  --output FILE      write result to FILE instead of stdout\n"
+           "  --no-trajectory    write the fit only\n"
+           "  --metrics FILE     dump metrics as JSON (needs METRICS_ENABLED build)\n"
+           "  --surface FILE     write the mse surface for the GUI's --surface instead of optimizing\n"
+           "  --surface-size N   samples per side of the surface (default 4096)\n"
+           "  --k-min K --k-max K --b-min B --b-max B  extent of the surface (default -7.5 7.5 -2.5 12.5)\n";
+}
+
+static bool parse(int argc, char* argv[], options& opt)
+{
+    std::map<std::string, std::function<void(char const*)>> const flags = {
+        {"--input",     [&opt](char const* arg) { opt.input = arg; }},
+        {"--output",    [&opt](char const* arg) { opt.output = arg; }},
+        {"--metrics",   [&opt](char const* arg) { opt.metrics = arg; }},
+        {"--optimizer", [&opt](char const* arg) { opt.optimizer = arg; }},
+        {"--n",         [&opt](char const* arg) { opt.n = std::stoi(arg); }},
+        {"--k",         [&opt](char const* arg) { opt.k = std::stod(arg); }},
+        {"--b",         [&opt](char const* arg) { opt.b = std::stod(arg); }},
+        {"--x-min",     [&opt](char const* arg) { opt.x_min = std::stod(arg); }},
+        {"--x-max",     [&opt](char const* arg) { opt.x_max = std::stod(arg); }},
+        {"--delta",     [&opt](char const* arg) { opt.delta = std::stod(arg); }},
+        {"--lrk",       [&opt](char const* arg) { opt.lrk = std::stod(arg); }},
+        {"--lrb",       [&opt](char const* arg) { opt.lrb = std::stod(arg); }},
+        {"--dlt",       [&opt](char const* arg) { opt.dlt = std::stod(arg); }},
+        {"--max-step",  [&opt](char const* arg) { opt.max_step = std::stoi(arg); }},
+        {"--batch",     [&opt](char const* arg) { opt.batch = std::stoi(arg); }},
+        {"--seed",      [&opt](char const* arg) { opt.seed = std::stoll(arg); }},
+        {"--surface",   [&opt](char const* arg) { opt.surface = arg; }},
+        {"--surface-size", [&opt](char const* arg) { opt.surface_size = std::stoi(arg); }},
+        {"--k-min",     [&opt](char const* arg) { opt.k_min = std::stod(arg); }},
+        {"--k-max",     [&opt](char const* arg) { opt.k_max = std::stod(arg); }},
+        {"--b-min",     [&opt](char const* arg) { opt.b_min = std::stod(arg); }},
+        {"--b-max",     [&opt](char const* arg) { opt.b_max = std::stod(arg); }},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--no-trajectory") == 0) {
+            opt.trajectory = false;
+            continue;
+        }
+        auto flag = flags.find(argv[i]);
+        if (flag == flags.end() || i + 1 == argc) {
+            std::cerr << "unknown or incomplete option: " << argv[i] << '\n';
+            return false;
+        }
+        try {
+            flag->second(argv[++i]);
+        } catch (std::exception const&) {
+            std::cerr << "bad value for " << argv[i - 1] << ": " << argv[i] << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+static way_t load_points(std::istream& in)
+{
+    way_t points;
+    double x, y;
+    while (in >> x >> y) {
+        points.emplace_back(x, y);
+    }
+    return points;
+}
+
+int main(int argc, char* argv[])
+{
+    options opt;
+    if (argc > 1 && (std::strcmp(argv[1], "--help") == 0 || std::strcmp(argv[1], "-h") == 0)) {
+        usage(std::cout);
+        return 0;
+    }
+    if (!parse(argc, argv, opt)) {
+        usage(std::cerr);
+        return 1;
+    }
+
+    if (opt.seed >= 0) {
+        set_seed(opt.seed);
+    }
+
+    way_t points;
+    if (opt.input.empty()) {
+        points = get_points_by_line(opt.n, opt.k, opt.b, opt.x_min, opt.x_max, opt.delta);
+    } else if (opt.input == "-") {
+        points = load_points(std::cin);
+    } else {
+        std::ifstream fin(opt.input);
+        if (!fin) {
+            std::cerr << "can't open " << opt.input << '\n';
+            return 1;
+        }
+        points = load_points(fin);
+    }
+    if (points.size() < 2) {
+        std::cerr << "need at least two points\n";
+        return 1;
+    }
+
+    if (!opt.surface.empty()) {
+        surface_header header;
+        header.width = header.height = static_cast<uint64_t>(std::max(opt.surface_size, 0));
+        header.x_min = opt.k_min;
+        header.x_max = opt.k_max;
+        header.y_min = opt.b_min;
+        header.y_max = opt.b_max;
+        auto const f = [&points](double const k, double const b) { return mse(points, k, b); };
+        if (!write_surface(opt.surface, header, f)) {
+            std::cerr << "can't write surface " << opt.surface << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    // stopping criteria compare against the closed-form optimum
+    auto const optimum = least_squares(points);
+
+    std::map<std::string, std::function<v<way_point>()>> const optimizers = {
+        {"momentum", [&] { return momentum_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt); }},
+        {"nesterov", [&] { return nesterov_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt); }},
+        {"adagrad",  [&] { return adagrad_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt); }},
+        {"rmsprop",  [&] { return rmsprop_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt); }},
+        {"adam",     [&] { return adam_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt); }},
+        {"sgd",      [&] {
+             auto result = sdg_linear_regression(points, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt);
+             return v<way_point>{{0, 0, 0}, {static_cast<double>(std::get<2>(result)), std::get<0>(result), std::get<1>(result)}};
+         }},
+        {"batch",    [&] {
+             auto result = linear_regression(points, opt.batch, opt.lrk, opt.lrb, optimum.first, optimum.second, opt.max_step, opt.dlt);
+             return v<way_point>{{0, 0, 0}, {static_cast<double>(std::get<2>(result)), std::get<0>(result), std::get<1>(result)}};
+         }},
+    };
+
+    auto optimizer = optimizers.find(opt.optimizer);
+    if (optimizer == optimizers.end()) {
+        std::cerr << "unknown optimizer: " << opt.optimizer << '\n';
+        return 1;
+    }
+    if (opt.optimizer == "batch" && (opt.batch <= 0 || opt.batch > static_cast<int>(points.size()))) {
+        std::cerr << "batch must be in [1, " << points.size() << "]\n";
+        return 1;
+    }
+
+    auto const way = optimizer->second();
+
+    std::ofstream fout;
+    if (!opt.output.empty()) {
+        fout.open(opt.output);
+        if (!fout) {
+            std::cerr << "can't open " << opt.output << '\n';
+            return 1;
+        }
+    }
+    std::ostream& out = opt.output.empty() ? std::cout : fout;
+
+    out.precision(17);
+    out << "# optimizer " << opt.optimizer << '\n'
+        << "# optimum k " << optimum.first << " b " << optimum.second << '\n'
+        << "# fit k " << way.back().k << " b " << way.back().b
+        << " steps " << static_cast<long long>(way.back().t)
+        << " mse " << mse(points, way.back().k, way.back().b) << '\n';
+    if (opt.trajectory) {
+        out << "# t k b\n";
+        for (auto const& elem : way) {
+            out << elem.t << ' ' << elem.k << ' ' << elem.b << '\n';
+        }
+    }
+
+    if (!opt.metrics.empty()) {
+        METRICS_DUMP(opt.metrics);
+    }
+    return out ? 0 : 1;
+}
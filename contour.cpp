@@ -0,0 +1,235 @@
+#include "contour.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include "parallel.h"
+
+// rows of cells traced by one task
+static size_t const band_rows = 64;
+
+// edge of the grid: 2 * index of its first sample, + 1 for the edge to the upper neighbour instead of the right one
+using edge_t = uint64_t;
+
+static size_t const none = std::numeric_limits<size_t>::max();
+
+struct link_t {
+    size_t piece;
+    // runs from its back to its front
+    bool reversed;
+};
+
+struct chain_t {
+    v<link_t> links;
+    bool closed = false;
+};
+
+// joins pieces running between two edges into chains, pieces meet where they end at the same edge;
+// an edge ends at most two pieces, so chains never branch
+static v<chain_t> link_pieces(v<pr<edge_t, edge_t>> const& ends)
+{
+    std::unordered_map<edge_t, std::array<size_t, 2>> at;
+    at.reserve(2 * ends.size());
+    for (size_t i = 0; i < ends.size(); ++i) {
+        for (edge_t const e : {ends[i].first, ends[i].second}) {
+            auto& pieces = at.try_emplace(e, std::array<size_t, 2>{none, none}).first->second;
+            pieces[pieces[0] == none ? 0 : 1] = i;
+        }
+    }
+    // the piece other than p ending at e, if any
+    auto other = [&at](edge_t const e, size_t const p) {
+        auto const& pieces = at.find(e)->second;
+        return pieces[0] == p ? pieces[1] : pieces[0];
+    };
+    auto far_end = [&ends](size_t const p, edge_t const e) {
+        return ends[p].first == e ? ends[p].second : ends[p].first;
+    };
+
+    v<chain_t> result;
+    v<bool> used(ends.size(), false);
+    for (size_t p = 0; p < ends.size(); ++p) {
+        if (used[p]) {
+            continue;
+        }
+        // walk back to a free end; a cycle may start anywhere
+        size_t start = p;
+        edge_t entry = ends[p].first;
+        for (size_t q; (q = other(entry, start)) != none && q != p; ) {
+            entry = far_end(q, entry);
+            start = q;
+        }
+        if (start != p && other(entry, start) == p) {
+            start = p;
+            entry = ends[p].first;
+        }
+
+        chain_t chain;
+        for (size_t cur = start; ; ) {
+            used[cur] = true;
+            bool const reversed = ends[cur].second == entry;
+            chain.links.push_back({cur, reversed});
+            edge_t const exit = reversed ? ends[cur].first : ends[cur].second;
+            size_t const next = other(exit, cur);
+            if (next == none) {
+                break;
+            }
+            if (next == start) {
+                chain.closed = true;
+                break;
+            }
+            cur = next;
+            entry = exit;
+        }
+        result.push_back(std::move(chain));
+    }
+    return result;
+}
+
+// polyline of a band running from edge `front` to edge `back` on the band border
+struct piece_t {
+    edge_t front;
+    edge_t back;
+    way_t points;
+};
+
+// iso-line at level through the cells of rows [row0, row1): closed lines go to `lines`,
+// the others may continue in a neighbouring band and go to `pieces`
+static void trace_band(contour_grid const& grid, double const level, size_t const row0, size_t const row1,
+                       v<contour_line>& lines, v<piece_t>& pieces)
+{
+    size_t const w = grid.width;
+    double const dx = (grid.x_max - grid.x_min) / static_cast<double>(w - 1);
+    double const dy = (grid.y_max - grid.y_min) / static_cast<double>(grid.height - 1);
+    // linear interpolation of the crossing along the edge
+    auto point = [&grid, level, w, dx, dy](edge_t const e) {
+        size_t const s = e / 2;
+        double const z0 = grid.z[s];
+        double const z1 = e % 2 == 0 ? grid.z[s + 1] : grid.z[s + w];
+        double const t = (level - z0) / (z1 - z0);
+        double const x = grid.x_min + static_cast<double>(s % w) * dx;
+        double const y = grid.y_min + static_cast<double>(s / w) * dy;
+        return e % 2 == 0 ? pr<double, double>{x + t * dx, y} : pr<double, double>{x, y + t * dy};
+    };
+
+    v<pr<edge_t, edge_t>> segments;
+    for (size_t j = row0; j < row1; ++j) {
+        double const* lower = grid.z + j * w;
+        double const* upper = lower + w;
+        for (size_t i = 0; i + 1 < w; ++i) {
+            double const a = lower[i], b = lower[i + 1], c = upper[i + 1], d = upper[i];
+            if (std::isnan(a + b + c + d)) {
+                continue;
+            }
+            int const index = (a > level) | (b > level) << 1 | (c > level) << 2 | (d > level) << 3;
+            edge_t const s = j * w + i;
+            edge_t const bottom = 2 * s, right = 2 * (s + 1) + 1, top = 2 * (s + w), left = 2 * s + 1;
+            switch (index) {
+            case 0: case 15: break;
+            case 1: case 14: segments.push_back({left, bottom}); break;
+            case 2: case 13: segments.push_back({bottom, right}); break;
+            case 3: case 12: segments.push_back({left, right}); break;
+            case 4: case 11: segments.push_back({right, top}); break;
+            case 6: case 9: segments.push_back({bottom, top}); break;
+            case 7: case 8: segments.push_back({top, left}); break;
+            default: {
+                // saddle: the mean of the corners decides which diagonal pair is connected
+                bool const center = (a + b + c + d) / 4 > level;
+                if ((index == 5) == center) {
+                    segments.push_back({bottom, right});
+                    segments.push_back({top, left});
+                } else {
+                    segments.push_back({left, bottom});
+                    segments.push_back({right, top});
+                }
+            }
+            }
+        }
+    }
+
+    for (auto const& chain : link_pieces(segments)) {
+        auto const& first = chain.links.front();
+        edge_t const front = first.reversed ? segments[first.piece].second : segments[first.piece].first;
+        edge_t back = front;
+        way_t points = {point(front)};
+        points.reserve(chain.links.size() + 1);
+        for (auto const& link : chain.links) {
+            back = link.reversed ? segments[link.piece].first : segments[link.piece].second;
+            points.push_back(point(back));
+        }
+        if (chain.closed) {
+            lines.push_back({std::move(points), true});
+        } else {
+            pieces.push_back({front, back, std::move(points)});
+        }
+    }
+}
+
+v<v<contour_line>> marching_squares(contour_grid const& grid, v<double> const& levels, unsigned threads)
+{
+    v<v<contour_line>> result(levels.size());
+    if (grid.width < 2 || grid.height < 2) {
+        return result;
+    }
+
+    size_t const bands = (grid.height - 1 + band_rows - 1) / band_rows;
+    v<v<contour_line>> lines(levels.size() * bands);
+    v<v<piece_t>> pieces(levels.size() * bands);
+    parallel_for(levels.size() * bands, [&](size_t const task) {
+        size_t const band = task % bands;
+        size_t const row0 = band * band_rows;
+        trace_band(grid, levels[task / bands], row0, std::min(row0 + band_rows, grid.height - 1), lines[task], pieces[task]);
+    }, threads);
+
+    // stitch the pieces of neighbouring bands, they end at the same edges of the rows between the bands
+    parallel_for(levels.size(), [&](size_t const l) {
+        v<piece_t> open;
+        for (size_t band = 0; band < bands; ++band) {
+            auto& band_lines = lines[l * bands + band];
+            std::move(band_lines.begin(), band_lines.end(), std::back_inserter(result[l]));
+            auto& band_pieces = pieces[l * bands + band];
+            std::move(band_pieces.begin(), band_pieces.end(), std::back_inserter(open));
+        }
+        v<pr<edge_t, edge_t>> ends;
+        ends.reserve(open.size());
+        for (auto const& elem : open) {
+            ends.push_back({elem.front, elem.back});
+        }
+        for (auto const& chain : link_pieces(ends)) {
+            contour_line line;
+            line.closed = chain.closed;
+            for (auto const& link : chain.links) {
+                way_t const& points = open[link.piece].points;
+                // the joint is the last point of the previous piece already
+                size_t const skip = line.points.empty() ? 0 : 1;
+                if (link.reversed) {
+                    line.points.insert(line.points.end(), points.rbegin() + skip, points.rend());
+                } else {
+                    line.points.insert(line.points.end(), points.begin() + skip, points.end());
+                }
+            }
+            result[l].push_back(std::move(line));
+        }
+    }, threads);
+    return result;
+}
+
+v<v<contour_line>> marching_squares(std::function<double(double, double)> const& f, size_t width, size_t height,
+                                    double x_min, double x_max, double y_min, double y_max,
+                                    v<double> const& levels, unsigned threads)
+{
+    if (width < 2 || height < 2) {
+        return v<v<contour_line>>(levels.size());
+    }
+    v<double> z(width * height);
+    double const dx = (x_max - x_min) / static_cast<double>(width - 1);
+    double const dy = (y_max - y_min) / static_cast<double>(height - 1);
+    parallel_for(height, [&](size_t const j) {
+        double const y = y_min + static_cast<double>(j) * dy;
+        for (size_t i = 0; i < width; ++i) {
+            z[j * width + i] = f(x_min + static_cast<double>(i) * dx, y);
+        }
+    }, threads);
+    return marching_squares({z.data(), width, height, x_min, x_max, y_min, y_max}, levels, threads);
+}
@@ -0,0 +1,33 @@
+#ifndef CONTOUR_H
+#define CONTOUR_H
+#include <functional>
+#include "algos.h"
+
+// width x height samples, z[j * width + i] at (x_min + i * (x_max - x_min) / (width - 1), y_min + j * ...):
+// like the cells of a QCPColorMapData, the outer samples lie on the bounds
+struct contour_grid {
+    double const* z;
+    size_t width;
+    size_t height;
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+};
+
+struct contour_line {
+    way_t points;
+    // the last point equals the first one
+    bool closed = false;
+};
+
+// iso-lines of every level by marching squares, result[l] for levels[l]; cells touching NaN have no lines.
+// Row bands of the grid are traced in parallel and their pieces joined where they meet
+v<v<contour_line>> marching_squares(contour_grid const& grid, v<double> const& levels, unsigned threads = 0);
+
+// same, for f sampled on width x height points over [x_min, x_max] x [y_min, y_max]
+v<v<contour_line>> marching_squares(std::function<double(double, double)> const& f, size_t width, size_t height,
+                                    double x_min, double x_max, double y_min, double y_max,
+                                    v<double> const& levels, unsigned threads = 0);
+
+#endif // CONTOUR_H
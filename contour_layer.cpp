@@ -0,0 +1,145 @@
+#include "contour_layer.h"
+#include <algorithm>
+#include <memory>
+
+// iso-lines are traced on a grid this many pixels apart
+static int const pixels_per_sample = 4;
+
+v<v<contour_line>> marching_squares(QCPColorMapData const* data, v<double> const& levels)
+{
+    size_t const width = static_cast<size_t>(data->keySize());
+    size_t const height = static_cast<size_t>(data->valueSize());
+    v<double> z(width * height);
+    for (size_t j = 0; j < height; ++j) {
+        for (size_t i = 0; i < width; ++i) {
+            z[j * width + i] = data->cell(static_cast<int>(i), static_cast<int>(j));
+        }
+    }
+    return marching_squares({z.data(), width, height, data->keyRange().lower, data->keyRange().upper,
+                             data->valueRange().lower, data->valueRange().upper}, levels);
+}
+
+contour_layer::contour_layer(QCPColorMap* color_map, QCPLayer* layer, loss_t f, QPen const& pen)
+    : QObject(color_map), color_map(color_map), layer(layer), f(std::move(f)), pen(pen)
+{
+    connect(color_map->keyAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &contour_layer::schedule_update);
+    connect(color_map->valueAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &contour_layer::schedule_update);
+    connect(color_map, &QCPColorMap::dataRangeChanged, this, &contour_layer::schedule_update);
+    connect(color_map, &QCPColorMap::gradientChanged, this, &contour_layer::schedule_update);
+    connect(color_map->parentPlot(), &QCustomPlot::afterLayout, this, &contour_layer::schedule_update);
+    schedule_update();
+}
+
+contour_layer::~contour_layer()
+{
+    jobs.cancel();
+    jobs.wait();
+}
+
+void contour_layer::schedule_update()
+{
+    if (!update_queued) {
+        update_queued = true;
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    }
+}
+
+void contour_layer::update()
+{
+    update_queued = false;
+    if (!color_map) {
+        return;
+    }
+
+    QCPRange const key_range = color_map->keyAxis()->range();
+    QCPRange const value_range = color_map->valueAxis()->range();
+    QCPRange const data_range = color_map->dataRange();
+    QRect const rect = color_map->keyAxis()->axisRect()->rect();
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        return;
+    }
+    // afterLayout fires on every replot, so most updates find nothing new
+    if (key_range == last_key_range && value_range == last_value_range && data_range == last_data_range && rect == last_rect) {
+        return;
+    }
+    last_key_range = key_range;
+    last_value_range = value_range;
+    last_data_range = data_range;
+    last_rect = rect;
+
+    // borders between the color levels of the gradient
+    int const count = color_map->gradient().levelCount();
+    v<double> levels;
+    for (int i = 1; i < count - 1; ++i) {
+        levels.push_back(data_range.lower + data_range.size() * i / (count - 1));
+    }
+
+    // only the latest view is extracted and shown
+    uint64_t const current = ++generation;
+    auto post = [this, current](v<v<contour_line>> lines) {
+        auto shared = std::make_shared<v<v<contour_line>> const>(std::move(lines));
+        QMetaObject::invokeMethod(this, [this, shared, current] {
+            if (generation == current) {
+                show(*shared);
+            }
+        }, Qt::QueuedConnection);
+    };
+    if (f) {
+        size_t const width = static_cast<size_t>(std::max(2, rect.width() / pixels_per_sample));
+        size_t const height = static_cast<size_t>(std::max(2, rect.height() / pixels_per_sample));
+        jobs.submit([this, current, post, key_range, value_range, width, height, levels] {
+            if (generation == current) {
+                post(marching_squares(f, width, height, key_range.lower, key_range.upper,
+                                      value_range.lower, value_range.upper, levels));
+            }
+        });
+    } else {
+        // the map may get new data while the copy is traced
+        auto data = std::make_shared<QCPColorMapData>(*color_map->data());
+        jobs.submit([this, current, post, data, levels] {
+            if (generation == current) {
+                post(marching_squares(data.get(), levels));
+            }
+        });
+    }
+}
+
+void contour_layer::show(v<v<contour_line>> const& lines)
+{
+    if (!color_map || !layer) {
+        return;
+    }
+    QCustomPlot* plot = color_map->parentPlot();
+    while (curves.size() > lines.size()) {
+        if (curves.back()) {
+            plot->removePlottable(curves.back());
+        }
+        curves.pop_back();
+    }
+    curves.resize(lines.size());
+
+    for (size_t l = 0; l < lines.size(); ++l) {
+        if (!curves[l]) {
+            QCPCurve* curve = new QCPCurve(color_map->keyAxis(), color_map->valueAxis());
+            curve->setLayer(layer);
+            curve->setPen(pen);
+            curve->removeFromLegend();
+            curve->setSelectable(QCP::stNone);
+            curve->setAdaptiveSampling(true);
+            curves[l] = curve;
+        }
+        // all lines of a level in one curve, separated by NaN gaps
+        QVector<QCPCurveData> data;
+        double t = 0;
+        for (auto const& line : lines[l]) {
+            if (!data.isEmpty()) {
+                data.push_back({t++, qQNaN(), qQNaN()});
+            }
+            for (auto const& point : line.points) {
+                data.push_back({t++, point.first, point.second});
+            }
+        }
+        curves[l]->data()->set(data, true);
+    }
+    request_replot(plot, layer);
+}
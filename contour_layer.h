@@ -0,0 +1,52 @@
+#ifndef CONTOUR_LAYER_H
+#define CONTOUR_LAYER_H
+
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include <functional>
+#include "qcustomplot.h"
+#include "contour.h"
+#include "replot_scheduler.h"
+#include "thread_pool.h"
+
+// iso-lines of the cells of a color map data
+v<v<contour_line>> marching_squares(QCPColorMapData const* data, v<double> const& levels);
+
+// iso-lines at the borders between the color levels of a color map, one QCPCurve per level on
+// `layer`, which should be buffered so new lines repaint only it. They are extracted in the thread
+// pool from f sampled over the visible ranges, or from the cells of the map if f is empty, whenever
+// the view or the data range of the map changes
+class contour_layer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using loss_t = std::function<double(double, double)>;
+
+    contour_layer(QCPColorMap* color_map, QCPLayer* layer, loss_t f, QPen const& pen = QPen(QColor(255, 255, 255, 110), 1));
+    ~contour_layer() override;
+
+private:
+    // coalesce range changes into one update per event loop iteration
+    void schedule_update();
+    void update();
+    void show(v<v<contour_line>> const& lines);
+
+    QPointer<QCPColorMap> color_map;
+    QPointer<QCPLayer> layer;
+    loss_t f;
+    QPen pen;
+    v<QPointer<QCPCurve>> curves;
+    std::atomic<uint64_t> generation{0};
+    bool update_queued = false;
+    QCPRange last_key_range;
+    QCPRange last_value_range;
+    QCPRange last_data_range;
+    QRect last_rect;
+
+    // declared last: cancelled and joined before anything the tasks use is destroyed
+    task_group jobs;
+};
+
+#endif // CONTOUR_LAYER_H
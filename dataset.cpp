@@ -0,0 +1,68 @@
+#include "dataset.h"
+#include "parallel.h"
+#include "rand.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+static constexpr size_t chunk_size = size_t{1} << 16;
+
+void synthesize(std::span<pr<double, double>> out, dataset_spec const& spec, unsigned threads)
+{
+    size_t const chunks = (out.size() + chunk_size - 1) / chunk_size;
+    double const two_pi = 2 * std::numbers::pi;
+
+    // point i takes x and noise from philox(seed, 0, i) and its outlier shift from philox(seed, 1, i)
+    parallel_for(chunks, [&out, &spec, two_pi](size_t const chunk) {
+        size_t const end = std::min(out.size(), (chunk + 1) * chunk_size);
+
+        for (size_t i = chunk * chunk_size; i < end; ++i) {
+            auto const w = philox(spec.seed, 0, i);
+            double const x = spec.x_min + to_unit(w[0], w[1]) * (spec.x_max - spec.x_min);
+            double y = 0;
+            for (size_t j = spec.coefs.size(); j-- > 0;) {
+                y = y * x + spec.coefs[j];
+            }
+
+            if (spec.noise == noise_kind::normal) {
+                double const u1 = (w[2] + 1.) * 0x1.0p-32;
+                double const u2 = w[3] * 0x1.0p-32;
+                y += spec.delta * std::sqrt(-2 * std::log(u1)) * std::cos(two_pi * u2);
+            } else {
+                y += spec.delta * (2 * to_unit(w[2], w[3]) - 1);
+            }
+
+            if (spec.outliers > 0) {
+                auto const o = philox(spec.seed, 1, i);
+                if (to_unit(o[0], o[1]) < spec.outliers) {
+                    y += spec.outlier_delta * (2 * to_unit(o[2], o[3]) - 1);
+                }
+            }
+            out[i] = {x, y};
+        }
+    }, threads);
+}
+
+way_t synthesize(size_t n, dataset_spec const& spec, unsigned threads)
+{
+    way_t points(n);
+    synthesize(points, spec, threads);
+    return points;
+}
+
+way_t get_points_by_line(int n, const double k, const double b, const double x_min, const double x_max, const double delta)
+{
+    return get_points_polynomial(n, {b, k}, x_min, x_max, delta);
+}
+
+way_t get_points_polynomial(int n, v<double> const& coefs, double const x_min, double const x_max, double const delta)
+{
+    dataset_spec spec;
+    spec.coefs = coefs;
+    spec.x_min = x_min;
+    spec.x_max = x_max;
+    spec.delta = delta;
+    spec.seed = thread_rng()();
+    // a negative count would wrap to a huge size_t
+    return synthesize(static_cast<size_t>(std::max(n, 0)), spec);
+}
@@ -0,0 +1,37 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstdint>
+#include <span>
+#include "algos.h"
+
+enum class noise_kind {
+    uniform, // uniform in [-delta, delta]
+    normal   // normal with standard deviation delta
+};
+
+// y = coefs[0] + coefs[1] * x + ... + noise, x uniform in [x_min, x_max];
+// with probability `outliers` a point gets an extra uniform shift from [-outlier_delta, outlier_delta]
+struct dataset_spec {
+    v<double> coefs;
+    double x_min = 0;
+    double x_max = 10;
+    noise_kind noise = noise_kind::uniform;
+    double delta = 0;
+    double outliers = 0;
+    double outlier_delta = 0;
+    uint64_t seed = 0;
+};
+
+// fill preallocated storage in parallel chunks; every point is derived from (seed, index) alone,
+// so the result depends only on spec and never on the number of threads (0 means hardware concurrency)
+void synthesize(std::span<pr<double, double>> out, dataset_spec const& spec, unsigned threads = 0);
+
+way_t synthesize(size_t n, dataset_spec const& spec, unsigned threads = 0);
+
+// seeded from the calling thread's generator, see set_seed
+way_t get_points_by_line(int n, double const k, double const b, double const x_min, double const x_max, double const delta);
+
+way_t get_points_polynomial(int n, v<double> const& coefs, double const x_min, double const x_max, double const delta);
+
+#endif // DATASET_H
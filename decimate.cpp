@@ -0,0 +1,137 @@
+#include "decimate.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// distance from p to the segment [a, b]
+static double segment_distance(double const px, double const py,
+                               double const ax, double const ay, double const bx, double const by) noexcept
+{
+    double const dx = bx - ax;
+    double const dy = by - ay;
+    double const len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0;
+    t = std::clamp(t, 0., 1.);
+    return std::hypot(px - ax - t * dx, py - ay - t * dy);
+}
+
+// ranges longer than this are split in the middle rather than at their farthest point
+static size_t const max_span = 4096;
+
+v<double> dp_importance(v<double> const& x, v<double> const& y, double const min_tolerance)
+{
+    size_t const n = x.size();
+    v<double> result(n, 0.);
+    if (n == 0) {
+        return result;
+    }
+    result.front() = result.back() = std::numeric_limits<double>::infinity();
+
+    struct range {
+        size_t first;
+        size_t last;
+        double bound;
+    };
+    // explicit stack: a million-step way would overflow a recursive one
+    v<range> stack = {{0, n - 1, std::numeric_limits<double>::infinity()}};
+    while (!stack.empty()) {
+        range const r = stack.back();
+        stack.pop_back();
+        if (r.last - r.first < 2) {
+            continue;
+        }
+        // ties go to the point nearest the middle: stalled or straight stretches split in halves,
+        // not one point at a time, which would take quadratic time
+        size_t const middle = r.first + (r.last - r.first) / 2;
+        size_t split = r.first + 1;
+        double farthest = -1;
+        for (size_t i = r.first + 1; i < r.last; ++i) {
+            double const d = segment_distance(x[i], y[i], x[r.first], y[r.first], x[r.last], y[r.last]);
+            if (d > farthest || (d == farthest && (i > middle ? i - middle : middle - i) < (split > middle ? split - middle : middle - split))) {
+                farthest = d;
+                split = i;
+            }
+        }
+        // a point can't outlive the split that made its segment
+        double const bound = std::min(farthest, r.bound);
+        // the points in between stay at 0: nothing is ever asked for at a finer tolerance
+        if (farthest == 0 || bound < min_tolerance) {
+            continue;
+        }
+        // a long range is halved instead: peeling the farthest point off one end again and again, as a
+        // converging way does, would rescan the rest every time. The middle is kept at the tolerances the
+        // range needs splitting for, so no level deviates more, it may only keep a few more points
+        if (r.last - r.first > max_span) {
+            split = middle;
+        }
+        result[split] = bound;
+        stack.push_back({r.first, split, bound});
+        stack.push_back({split, r.last, bound});
+    }
+    return result;
+}
+
+way_pyramid::way_pyramid(v<way_point> way) : way(std::move(way))
+{
+    v<double> k, b;
+    k.reserve(this->way.size());
+    b.reserve(this->way.size());
+    for (auto const& elem : this->way) {
+        k.push_back(elem.k);
+        b.push_back(elem.b);
+    }
+    if (!k.empty()) {
+        auto const k_bounds = std::minmax_element(k.begin(), k.end());
+        auto const b_bounds = std::minmax_element(b.begin(), b.end());
+        k_extent = *k_bounds.second - *k_bounds.first;
+        b_extent = *b_bounds.second - *b_bounds.first;
+    }
+    // both axes scaled to [0, 1], so one tolerance fits any aspect ratio
+    double const k_scale = k_extent > 0 ? 1 / k_extent : 1;
+    double const b_scale = b_extent > 0 ? 1 / b_extent : 1;
+    for (size_t i = 0; i < k.size(); ++i) {
+        k[i] *= k_scale;
+        b[i] *= b_scale;
+    }
+    // levels below max_level keep points down to 2^-(max_level - 1), max_level itself is the full way
+    importance = dp_importance(k, b, std::ldexp(1., 1 - max_level));
+}
+
+int way_pyramid::level_index(double const k_tolerance, double const b_tolerance) const
+{
+    // the smaller relative tolerance bounds the error along both axes
+    double const k_relative = k_extent > 0 ? k_tolerance / k_extent : std::numeric_limits<double>::infinity();
+    double const b_relative = b_extent > 0 ? b_tolerance / b_extent : std::numeric_limits<double>::infinity();
+    double const tolerance = std::min(k_relative, b_relative);
+    if (!(tolerance < 1)) {
+        return 0;
+    }
+    if (!(tolerance > 0)) {
+        return max_level;
+    }
+    return std::min(max_level, static_cast<int>(std::ceil(-std::log2(tolerance))));
+}
+
+v<way_point> const& way_pyramid::level(int const index)
+{
+    if (index >= max_level) {
+        return way;
+    }
+    auto it = levels.find(index);
+    if (it != levels.end()) {
+        return it->second;
+    }
+    double const tolerance = std::ldexp(1., -index);
+    v<way_point> result;
+    for (size_t i = 0; i < way.size(); ++i) {
+        if (importance[i] >= tolerance) {
+            result.push_back(way[i]);
+        }
+    }
+    return levels.emplace(index, std::move(result)).first->second;
+}
+
+v<way_point> const& way_pyramid::level_for(double const k_tolerance, double const b_tolerance)
+{
+    return level(level_index(k_tolerance, b_tolerance));
+}
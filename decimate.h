@@ -0,0 +1,39 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+#include <map>
+#include "algos.h"
+
+// Douglas–Peucker importance of every point of the polyline (x[i], y[i]): the largest tolerance
+// at which the point is still kept; first and last points are never dropped.
+// Importances never grow towards the leaves, so the points kept at a tolerance form nested sets.
+// Ranges of more than a few thousand points split in the middle, so the cost stays near n log n;
+// that keeps a few extra points, never more error. Importances below min_tolerance are reported as 0
+v<double> dp_importance(v<double> const& x, v<double> const& y, double const min_tolerance = 0);
+
+// trajectory with cached levels of detail: level l keeps the points whose importance,
+// measured in units of the k and b extents of the way, is at least 2^-l
+class way_pyramid {
+public:
+    explicit way_pyramid(v<way_point> way);
+
+    // coarsest level deviating from the full way by no more than k_tolerance along k and b_tolerance along b
+    v<way_point> const& level_for(double const k_tolerance, double const b_tolerance);
+
+    int level_index(double const k_tolerance, double const b_tolerance) const;
+    v<way_point> const& level(int const index);
+
+    v<way_point> const& full() const noexcept {
+        return way;
+    }
+
+private:
+    static int const max_level = 52;
+
+    v<way_point> way;
+    v<double> importance;
+    double k_extent = 0;
+    double b_extent = 0;
+    std::map<int, v<way_point>> levels;
+};
+
+#endif // DECIMATE_H
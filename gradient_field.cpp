@@ -0,0 +1,49 @@
+#include "gradient_field.h"
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+mse_moments moments(way_t const& points) noexcept
+{
+    mse_moments result;
+    if (points.empty()) {
+        return result;
+    }
+    for (auto const& elem : points) {
+        result.x += elem.first;
+        result.y += elem.second;
+        result.xx += elem.first * elem.first;
+        result.xy += elem.first * elem.second;
+    }
+    double const n = points.size();
+    result.x /= n;
+    result.y /= n;
+    result.xx /= n;
+    result.xy /= n;
+    return result;
+}
+
+void mse_descent(mse_moments const& m, double const* k, double const* b, size_t const n, double* dk, double* db) noexcept
+{
+    // d/dk = 2 (k xx + b x - xy), d/db = 2 (k x + b - y)
+    size_t i = 0;
+#if defined(__AVX__)
+    __m256d const xx = _mm256_set1_pd(-2 * m.xx);
+    __m256d const x = _mm256_set1_pd(-2 * m.x);
+    __m256d const xy = _mm256_set1_pd(2 * m.xy);
+    __m256d const y = _mm256_set1_pd(2 * m.y);
+    __m256d const two = _mm256_set1_pd(-2);
+    for (; i + 4 <= n; i += 4) {
+        __m256d const kv = _mm256_loadu_pd(k + i);
+        __m256d const bv = _mm256_loadu_pd(b + i);
+        __m256d const gk = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(kv, xx), _mm256_mul_pd(bv, x)), xy);
+        __m256d const gb = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(kv, x), _mm256_mul_pd(bv, two)), y);
+        _mm256_storeu_pd(dk + i, gk);
+        _mm256_storeu_pd(db + i, gb);
+    }
+#endif
+    for (; i < n; ++i) {
+        dk[i] = -2 * (k[i] * m.xx + b[i] * m.x - m.xy);
+        db[i] = -2 * (k[i] * m.x + b[i] - m.y);
+    }
+}
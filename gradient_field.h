@@ -0,0 +1,18 @@
+#ifndef GRADIENT_FIELD_H
+#define GRADIENT_FIELD_H
+#include "algos.h"
+
+// means of x, y, x^2 and xy over the points: the gradient of mse at any {k, b} in O(1)
+struct mse_moments {
+    double x = 0;
+    double y = 0;
+    double xx = 0;
+    double xy = 0;
+};
+
+mse_moments moments(way_t const& points) noexcept;
+
+// descent direction -grad mse at (k[i], b[i]) into (dk[i], db[i]) for i < n; AVX handles four points at a time
+void mse_descent(mse_moments const& m, double const* k, double const* b, size_t const n, double* dk, double* db) noexcept;
+
+#endif // GRADIENT_FIELD_H
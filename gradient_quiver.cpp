@@ -0,0 +1,135 @@
+#include "gradient_quiver.h"
+#include <algorithm>
+#include <cmath>
+
+// both sides of an arrow head, relative to its shaft
+static double const head_angle = 0.45;
+
+// shaft from `from` to `to` and the two sides of the head
+static void add_arrow(QVector<QLineF>& lines, QPointF const& from, QPointF const& to)
+{
+    QLineF const shaft(from, to);
+    double const head = std::min(6.0, 0.35 * shaft.length());
+    double const angle = std::atan2(from.y() - to.y(), from.x() - to.x());
+    lines.push_back(shaft);
+    lines.push_back({to, to + head * QPointF(std::cos(angle + head_angle), std::sin(angle + head_angle))});
+    lines.push_back({to, to + head * QPointF(std::cos(angle - head_angle), std::sin(angle - head_angle))});
+}
+
+gradient_quiver::gradient_quiver(QCPAxis* key_axis, QCPAxis* value_axis, mse_moments const& moments)
+    : QCPAbstractPlottable(key_axis, value_axis), moments(moments)
+{
+    setPen(QPen(QColor(255, 255, 255, 150), 1));
+    setBrush(Qt::NoBrush);
+    setSelectable(QCP::stNone);
+}
+
+void gradient_quiver::set_spacing(int const spacing)
+{
+    this->spacing = std::max(4, spacing);
+    arrows_rect = QRect();
+}
+
+double gradient_quiver::selectTest(QPointF const&, bool, QVariant*) const
+{
+    return -1;
+}
+
+// an overlay: rescaling the axes ignores it
+QCPRange gradient_quiver::getKeyRange(bool& foundRange, QCP::SignDomain) const
+{
+    foundRange = false;
+    return QCPRange();
+}
+
+QCPRange gradient_quiver::getValueRange(bool& foundRange, QCP::SignDomain, QCPRange const&) const
+{
+    foundRange = false;
+    return QCPRange();
+}
+
+void gradient_quiver::update_arrows()
+{
+    QCPAxis* key_axis = mKeyAxis.data();
+    QCPAxis* value_axis = mValueAxis.data();
+    QRect const rect = key_axis->axisRect()->rect();
+    arrows_key_range = key_axis->range();
+    arrows_value_range = value_axis->range();
+    arrows_rect = rect;
+    arrows.clear();
+
+    // arrow bases in the centers of spacing x spacing pixel cells
+    int const columns = rect.width() / spacing;
+    int const rows = rect.height() / spacing;
+    if (columns <= 0 || rows <= 0) {
+        return;
+    }
+    size_t const n = static_cast<size_t>(columns) * rows;
+    v<QPointF> base(n);
+    v<double> k(n), b(n), dk(n), db(n);
+    QPointF const offset(rect.left() + (rect.width() - (columns - 1) * spacing) / 2.0,
+                         rect.top() + (rect.height() - (rows - 1) * spacing) / 2.0);
+    for (int j = 0; j < rows; ++j) {
+        for (int i = 0; i < columns; ++i) {
+            size_t const index = static_cast<size_t>(j) * columns + i;
+            base[index] = offset + QPointF(i * spacing, j * spacing);
+            pixelsToCoords(base[index], k[index], b[index]);
+        }
+    }
+    mse_descent(moments, k.data(), b.data(), n, dk.data(), db.data());
+
+    // pixels per unit of k and of b, so arrows point the right way on screen whatever the aspect ratio
+    QPointF const origin = coordsToPixels(arrows_key_range.lower, arrows_value_range.lower);
+    QPointF const key_unit = (coordsToPixels(arrows_key_range.upper, arrows_value_range.lower) - origin) / arrows_key_range.size();
+    QPointF const value_unit = (coordsToPixels(arrows_key_range.lower, arrows_value_range.upper) - origin) / arrows_value_range.size();
+    v<QPointF> direction(n);
+    double longest = 0;
+    for (size_t i = 0; i < n; ++i) {
+        direction[i] = dk[i] * key_unit + db[i] * value_unit;
+        longest = std::max(longest, std::hypot(direction[i].x(), direction[i].y()));
+    }
+    if (!(longest > 0) || !std::isfinite(longest)) {
+        return;
+    }
+
+    double const max_length = 0.8 * spacing;
+    arrows.reserve(static_cast<int>(3 * n));
+    for (size_t i = 0; i < n; ++i) {
+        double const length = std::hypot(direction[i].x(), direction[i].y());
+        if (length < longest * 1e-12) {
+            continue;
+        }
+        double const scale = max_length * std::sqrt(length / longest) / length;
+        // centered on the grid point
+        QPointF const half = 0.5 * scale * direction[i];
+        add_arrow(arrows, base[i] - half, base[i] + half);
+    }
+}
+
+void gradient_quiver::draw(QCPPainter* painter)
+{
+    QCPAxis* key_axis = mKeyAxis.data();
+    QCPAxis* value_axis = mValueAxis.data();
+    if (!key_axis || !value_axis) {
+        return;
+    }
+    if (key_axis->range() != arrows_key_range || value_axis->range() != arrows_value_range
+            || key_axis->axisRect()->rect() != arrows_rect) {
+        update_arrows();
+    }
+    if (arrows.isEmpty()) {
+        return;
+    }
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLines(arrows);
+}
+
+void gradient_quiver::drawLegendIcon(QCPPainter* painter, QRectF const& rect) const
+{
+    QVector<QLineF> icon;
+    add_arrow(icon, QPointF(rect.left(), rect.center().y()), QPointF(rect.right(), rect.center().y()));
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLines(icon);
+}
@@ -0,0 +1,38 @@
+#ifndef GRADIENT_QUIVER_H
+#define GRADIENT_QUIVER_H
+
+#include "qcustomplot.h"
+#include "gradient_field.h"
+
+// arrows of -grad mse on a screen-space grid over the visible ranges, all drawn with a single
+// QPainter::drawLines call; the field is only recomputed when the axis ranges or the axis rect change.
+// Arrow lengths grow with the square root of the gradient, relative to the largest one in view
+class gradient_quiver : public QCPAbstractPlottable
+{
+public:
+    gradient_quiver(QCPAxis* key_axis, QCPAxis* value_axis, mse_moments const& moments);
+
+    // pixels between neighbouring arrows
+    void set_spacing(int const spacing);
+
+    double selectTest(QPointF const& pos, bool onlySelectable, QVariant* details = nullptr) const override;
+    QCPRange getKeyRange(bool& foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool& foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth, QCPRange const& inKeyRange = QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter* painter) override;
+    void drawLegendIcon(QCPPainter* painter, QRectF const& rect) const override;
+
+private:
+    void update_arrows();
+
+    mse_moments moments;
+    int spacing = 32;
+    // shafts and heads in pixels, for the view below
+    QVector<QLineF> arrows;
+    QCPRange arrows_key_range;
+    QCPRange arrows_value_range;
+    QRect arrows_rect;
+};
+
+#endif // GRADIENT_QUIVER_H
@@ -0,0 +1,217 @@
+#include "loss_surface.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+// missing tiles are filled from cached ancestors up to this many levels coarser
+static int const max_fallback = 6;
+// coarser level requested first, so a rough picture shows up quickly
+static int const preview_levels = 2;
+// upper bound for tiles per side of the view
+static int64_t const max_tiles = 32;
+// samples per side of the synchronous preview, cheap enough for the GUI thread
+static int const preview_samples = 32;
+
+loss_surface::loss_surface(QCPColorMap* color_map, loss_t f, size_t budget_bytes)
+    : QObject(color_map), color_map(color_map), f(std::move(f)), cache(budget_bytes)
+{
+    QCPColorGradient grad = color_map->gradient();
+    grad.setNanHandling(QCPColorGradient::nhTransparent);
+    color_map->setGradient(grad);
+
+    // the first frames show the preview rather than an empty map
+    compute_preview(color_map->keyAxis()->range(), color_map->valueAxis()->range());
+    double const key_step = preview_key_range.size() / preview_samples;
+    double const value_step = preview_value_range.size() / preview_samples;
+    auto data = new QCPColorMapData(preview_samples, preview_samples,
+                                    {preview_key_range.lower + key_step / 2, preview_key_range.upper - key_step / 2},
+                                    {preview_value_range.lower + value_step / 2, preview_value_range.upper - value_step / 2});
+    std::copy(preview.begin(), preview.end(), data->beginBulkWrite());
+    data->endBulkWrite();
+    color_map->setData(data);
+    color_map->rescaleDataRange(true);
+
+    connect(color_map->keyAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &loss_surface::schedule_update);
+    connect(color_map->valueAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &loss_surface::schedule_update);
+    connect(color_map->parentPlot(), &QCustomPlot::afterLayout, this, &loss_surface::schedule_update);
+    schedule_update();
+}
+
+loss_surface::~loss_surface()
+{
+    jobs.cancel();
+    jobs.wait();
+}
+
+void loss_surface::schedule_update()
+{
+    if (!update_queued) {
+        update_queued = true;
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    }
+}
+
+void loss_surface::update()
+{
+    update_queued = false;
+    if (!color_map) {
+        return;
+    }
+
+    QCPRange const key_range = color_map->keyAxis()->range();
+    QCPRange const value_range = color_map->valueAxis()->range();
+    QRect const rect = color_map->keyAxis()->axisRect()->rect();
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        return;
+    }
+    // afterLayout fires on every replot, so most updates find nothing new
+    bool const view_changed = key_range != last_key_range || value_range != last_value_range || rect != last_rect;
+    if (!view_changed && !tiles_changed) {
+        return;
+    }
+    last_key_range = key_range;
+    last_value_range = value_range;
+    last_rect = rect;
+    tiles_changed = false;
+    // the preview only depends on the ranges, a resize keeps it
+    preview_current = preview_current && key_range == preview_key_range && value_range == preview_value_range;
+
+    double const units_per_pixel = std::max(key_range.size() / rect.width(), value_range.size() / rect.height());
+    int level = grid.level_for(units_per_pixel);
+    auto tiles_of = [this, &key_range, &value_range](int const level) {
+        return std::array<int64_t, 4>{grid.tile_of(level, key_range.lower), grid.tile_of(level, key_range.upper),
+                                      grid.tile_of(level, value_range.lower), grid.tile_of(level, value_range.upper)};
+    };
+    auto tiles = tiles_of(level);
+    while (tiles[1] - tiles[0] >= max_tiles || tiles[3] - tiles[2] >= max_tiles) {
+        tiles = tiles_of(--level);
+    }
+
+    // queued tasks of an older view are skipped
+    if (view_changed) {
+        ++generation;
+    }
+    for (int const l : {level - preview_levels, level}) {
+        int const shift = level - l;
+        for (int64_t ty = tiles[2] >> shift; ty <= tiles[3] >> shift; ++ty) {
+            for (int64_t tx = tiles[0] >> shift; tx <= tiles[1] >> shift; ++tx) {
+                request({l, tx, ty});
+            }
+        }
+    }
+    compose(level, tiles[0], tiles[1], tiles[2], tiles[3]);
+}
+
+void loss_surface::request(tile_key const& key)
+{
+    if (pending.count(key) != 0 || cache.find(key)) {
+        return;
+    }
+    pending.insert(key);
+    uint64_t const current = generation;
+    jobs.submit([this, key, current] {
+        // a skipped tile is requested again by the next update if it is still visible
+        if (generation == current) {
+            cache.insert(key, compute_tile(grid, key, f));
+        }
+        QMetaObject::invokeMethod(this, [this, key] {
+            pending.erase(key);
+            tiles_changed = true;
+            schedule_update();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void loss_surface::compose(int level, int64_t tx0, int64_t tx1, int64_t ty0, int64_t ty1)
+{
+    int const n = grid.samples;
+    int const width = static_cast<int>(tx1 - tx0 + 1) * n;
+    int const height = static_cast<int>(ty1 - ty0 + 1) * n;
+    QCPRange const key_range(grid.coord(level, tx0, 0), grid.coord(level, tx1, n - 1));
+    QCPRange const value_range(grid.coord(level, ty0, 0), grid.coord(level, ty1, n - 1));
+
+    auto data = new QCPColorMapData(width, height, key_range, value_range);
+    double* cells = data->beginBulkWrite();
+    bool complete = true;
+    // bounds of the written values, so the map doesn't scan the cells again
+    double lower = std::numeric_limits<double>::infinity();
+    double upper = -std::numeric_limits<double>::infinity();
+
+    for (int64_t ty = ty0; ty <= ty1; ++ty) {
+        for (int64_t tx = tx0; tx <= tx1; ++tx) {
+            double* origin = cells + (ty - ty0) * n * width + (tx - tx0) * n;
+            tile_t tile = cache.find({level, tx, ty});
+            int up = 0;
+            for (; !tile && up < max_fallback; ) {
+                ++up;
+                tile = cache.find({level - up, tx >> up, ty >> up});
+            }
+            complete = complete && up == 0;
+            if (!tile && !preview_current) {
+                compute_preview(last_key_range, last_value_range);
+            }
+
+            // sample (i, j) of this tile lies in sample (offset + i) >> up of the ancestor
+            int const offset_x = static_cast<int>(tx - ((tx >> up) << up)) * n;
+            int const offset_y = static_cast<int>(ty - ((ty >> up) << up)) * n;
+            for (int j = 0; j < n; ++j) {
+                double* out = origin + j * width;
+                if (!tile) {
+                    double const value = grid.coord(level, ty, j);
+                    for (int i = 0; i < n; ++i) {
+                        out[i] = preview_at(grid.coord(level, tx, i), value);
+                        lower = out[i] < lower ? out[i] : lower;
+                        upper = out[i] > upper ? out[i] : upper;
+                    }
+                    continue;
+                }
+                double const* row = tile->data() + ((offset_y + j) >> up) * n;
+                for (int i = 0; i < n; ++i) {
+                    out[i] = row[(offset_x + i) >> up];
+                    // NaN fails both comparisons
+                    lower = out[i] < lower ? out[i] : lower;
+                    upper = out[i] > upper ? out[i] : upper;
+                }
+            }
+        }
+    }
+    if (lower <= upper) {
+        data->endBulkWrite({lower, upper});
+    } else {
+        data->endBulkWrite();
+    }
+
+    color_map->setData(data);
+    if (!data_range_set && complete) {
+        color_map->rescaleDataRange(true);
+        data_range_set = true;
+    }
+    request_replot(color_map->parentPlot());
+}
+
+void loss_surface::compute_preview(QCPRange const& key_range, QCPRange const& value_range)
+{
+    preview.resize(preview_samples * preview_samples);
+    preview_key_range = key_range;
+    preview_value_range = value_range;
+    preview_current = true;
+    double const key_step = key_range.size() / preview_samples;
+    double const value_step = value_range.size() / preview_samples;
+    for (int j = 0; j < preview_samples; ++j) {
+        double const value = value_range.lower + (j + 0.5) * value_step;
+        for (int i = 0; i < preview_samples; ++i) {
+            preview[j * preview_samples + i] = f(key_range.lower + (i + 0.5) * key_step, value);
+        }
+    }
+}
+
+double loss_surface::preview_at(double const key, double const value) const
+{
+    auto cell = [](double const coord, QCPRange const& range) {
+        double const i = std::floor((coord - range.lower) / range.size() * preview_samples);
+        // NaN goes to the first cell too
+        return i > 0 ? static_cast<int>(std::min(i, preview_samples - 1.)) : 0;
+    };
+    return preview[cell(value, preview_value_range) * preview_samples + cell(key, preview_key_range)];
+}
@@ -0,0 +1,60 @@
+#ifndef LOSS_SURFACE_H
+#define LOSS_SURFACE_H
+
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include <functional>
+#include <unordered_set>
+#include "qcustomplot.h"
+#include "replot_scheduler.h"
+#include "thread_pool.h"
+#include "tile_cache.h"
+
+// keeps a QCPColorMap filled with f(k, b) over the visible axis ranges: the surface is split into
+// tiles of several levels, missing tiles are computed in the thread pool when the view changes
+// and shown in place of coarser ones as they arrive. Until then a coarse preview of the view,
+// computed right away on the GUI thread, fills the parts no cached tile covers
+class loss_surface : public QObject
+{
+    Q_OBJECT
+
+public:
+    using loss_t = std::function<double(double, double)>;
+
+    loss_surface(QCPColorMap* color_map, loss_t f, size_t budget_bytes = size_t{256} << 20);
+    ~loss_surface() override;
+
+private:
+    // coalesce range changes into one update per event loop iteration
+    void schedule_update();
+    void update();
+    void request(tile_key const& key);
+    void compose(int level, int64_t tx0, int64_t tx1, int64_t ty0, int64_t ty1);
+    // samples f over the ranges into preview
+    void compute_preview(QCPRange const& key_range, QCPRange const& value_range);
+    // nearest preview sample, clamped to its edges
+    double preview_at(double const key, double const value) const;
+
+    QPointer<QCPColorMap> color_map;
+    loss_t f;
+    tile_grid grid;
+    tile_cache cache;
+    std::unordered_set<tile_key, tile_key_hash> pending;
+    v<double> preview;
+    QCPRange preview_key_range;
+    QCPRange preview_value_range;
+    bool preview_current = false;
+    std::atomic<uint64_t> generation{0};
+    bool update_queued = false;
+    bool tiles_changed = false;
+    bool data_range_set = false;
+    QCPRange last_key_range;
+    QCPRange last_value_range;
+    QRect last_rect;
+
+    // declared last: cancelled and joined before anything the tasks use is destroyed
+    task_group jobs;
+};
+
+#endif // LOSS_SURFACE_H
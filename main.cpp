@@ -1,10 +1,24 @@
 #include "mainwindow.h"
+#include "bench.h"
 
 #include <QApplication>
+#include <iostream>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    if (a.arguments().contains("--bench")) {
+        auto results = convergence_bench(bench_datasets(), bench_optimizers(), 100000, 1e-3);
+        print_bench_table(std::cout, results);
+
+        QCustomPlot plot;
+        plot_convergence(plot, results);
+        plot.resize(1000, 1400);
+        plot.show();
+        return a.exec();
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
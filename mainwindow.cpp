@@ -1,10 +1,19 @@
 #include "mainwindow.h"
+#include <algorithm>
 #include <cassert>
 #include <set>
 #include <tuple>
+#include "dataset.h"
 #include "rand.h"
+#include "metrics.h"
+#include "contour_layer.h"
+#include "gradient_quiver.h"
+#include "loss_surface.h"
+#include "mapped_surface.h"
 #include <fstream>
 #include <chrono>
+#include <memory>
+#include <QShortcut>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -13,6 +22,14 @@ MainWindow::MainWindow(QWidget *parent)
     plot.axisRect()->setupFullAxesBox(true);
     plot.xAxis->setLabel("k");
     plot.yAxis->setLabel("b");
+    setup_layers();
+
+    // slow frames switch to coarser ways until the plot is idle again
+    scheduler = new replot_scheduler(&plot);
+    connect(scheduler, &replot_scheduler::quality_changed, this, [this](bool const reduced) {
+        lod_pixels = reduced ? 2 : 0.5;
+        refresh_ways();
+    });
 
     start();
 
@@ -33,61 +50,92 @@ void MainWindow::start()
         qDebug() << "file doesn't exists";
     }
     fin >> k >> b >> lrk >> lrb >> dlt >> mx_step >> n;
+    // optional: seed for reproducible runs
+    unsigned long long seed;
+    if (fin >> seed) {
+        set_seed(seed);
+    }
     fin.close();
     qDebug() << "In:" << k << b << lrk << lrb << dlt << mx_step;
 
     auto points = get_points_by_line(500, k, b, 0, 10, 2);
-    auto started = std::chrono::high_resolution_clock::now();
 //    set_points(points, "Points");
 //    set_line(k, b, "Expected");
 
 //    auto result = linear_regression(points, 1, lrk, lrb, k, b, mx_step, dlt);
 //    qDebug() << std::get<2>(result) << func_str.arg(std::get<0>(result)).arg(std::get<1>(result));
-    auto momentum_result = momentum_linear_regression(points, lrk, lrb, k, b, mx_step, dlt);
-    auto nesterov_result = nesterov_linear_regression(points, lrk, lrb, k, b, mx_step, dlt);
-    auto adagrad_result = adagrad_linear_regression(points, lrk, lrb, k, b, mx_step, dlt);
-    auto rmsprop_result = rmsprop_linear_regression(points, lrk, lrb, k, b, mx_step, dlt);
-    auto adam_result = adam_linear_regression(points, lrk, lrb, k, b, mx_step, dlt);
 //    qDebug() << result.size() - 1 << func_str.arg(result.back().key).arg(result.back().value);
 
-    auto done = std::chrono::high_resolution_clock::now();
-    qDebug() << std::chrono::duration_cast<std::chrono::milliseconds>(done-started).count();
-
 //    set_line(result.back().key, result.back().value, "Result");
 //    set_line(std::get<0>(result), std::get<1>(result), "Result");
 
-    auto f = [&points] (qreal const k, qreal const b) {
-        return mse(points, k, b);
+    // shared with the tile tasks of the loss surface and the optimizers
+    auto shared_points = std::make_shared<way_t const>(points);
+    auto f = [shared_points] (qreal const k, qreal const b) {
+        return mse(*shared_points, k, b);
+    };
+
+    // --surface FILE shows a surface precomputed by lab2-cli instead of computing one
+    QStringList const args = QCoreApplication::arguments();
+    int const surface_arg = args.indexOf("--surface");
+    set_color_map({-7.5, -2.5}, {7.5, 12.5}, f, surface_arg >= 0 ? args.value(surface_arg + 1) : QString());
+
+    // where the descent pulls, to compare with the ways the optimizers take
+    auto quiver = new gradient_quiver(plot.xAxis, plot.yAxis, moments(points));
+    quiver->setName("-grad MSE");
+
+    // P plays the finished ways from step 0, + and - double or halve the speed
+    playback = new way_playback(markers_layer);
+    new QShortcut(QKeySequence("P"), this, [this] { playback->start(); });
+    new QShortcut(QKeySequence("+"), this, [this] { playback->set_steps_per_second(2 * playback->steps_per_second()); });
+    new QShortcut(QKeySequence("-"), this, [this] { playback->set_steps_per_second(0.5 * playback->steps_per_second()); });
+
+    auto optimizer = [=](auto const& regression) {
+        return [=](way_observer const& observer) {
+            return regression(*shared_points, lrk, lrb, k, b, mx_step, dlt, observer);
+        };
     };
+    run_way("Momentum", optimizer(momentum_linear_regression));
+    run_way("Nesterov", optimizer(nesterov_linear_regression));
+    run_way("AdaGrad", optimizer(adagrad_linear_regression));
+    run_way("RMSProp", optimizer(rmsprop_linear_regression));
+    run_way("Adam", optimizer(adam_linear_regression));
+
+    // streamed points are appended to the curves at most 30 times a second
+    connect(&drain_timer, &QTimer::timeout, this, &MainWindow::drain_ways);
+    drain_timer.start(1000 / 30);
+
+    connect(plot.xAxis, QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &MainWindow::refresh_ways);
+    connect(plot.yAxis, QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &MainWindow::refresh_ways);
+    connect(&plot, &QCustomPlot::afterLayout, this, &MainWindow::refresh_ways);
+
+    // Esc stops all running optimizers, their trajectories so far stay on the plot
+    new QShortcut(QKeySequence::Cancel, this, [this] { jobs.cancel(); });
+}
 
-    set_color_map({-7.5, -2.5}, {7.5, 12.5}, {500, 500}, f);
-    make_way(momentum_result, "Momentum");
-    make_way(nesterov_result, "Nesterov");
-    make_way(adagrad_result, "AdaGrad");
-    make_way(rmsprop_result, "RMSProp");
-    make_way(adam_result, "Adam");
+void MainWindow::setup_layers()
+{
+    // layers without a buffer of their own share one with the layers below them: the surface is drawn
+    // into the bottom buffer together with the background and the grid. The contours arrive after
+    // the surface and repaint only their own buffer; "main" starts the next shared one
+    plot.addLayer("surface", plot.layer("grid"), QCustomPlot::limAbove);
+    plot.addLayer("contours", plot.layer("surface"), QCustomPlot::limAbove);
+    plot.layer("contours")->setMode(QCPLayer::lmBuffered);
+    plot.addLayer("ways", plot.layer("main"), QCustomPlot::limAbove);
+    plot.addLayer("markers", plot.layer("ways"), QCustomPlot::limAbove);
+    ways_layer = plot.layer("ways");
+    ways_layer->setMode(QCPLayer::lmBuffered);
+    markers_layer = plot.layer("markers");
+    markers_layer->setMode(QCPLayer::lmBuffered);
 }
 
-void MainWindow::set_color_map(QPointF const& left_bottom, QPointF const& right_top,
-                               QSize const& resolution,
-                               auto const& f)
+void MainWindow::set_color_map(QPointF const& left_bottom, QPointF const& right_top, auto const& f, QString const& surface_path)
 {
-    QCPColorMap* color_map = new QCPColorMap(plot.xAxis, plot.yAxis);
+    color_map = new QCPColorMap(plot.xAxis, plot.yAxis);
+    color_map->setLayer("surface");
     plot.legend->removeItem(0);
-    color_map->data()->setSize(resolution.width(), resolution.height());
-    color_map->data()->setRange(QCPRange(left_bottom.x(), right_top.x()),
-                                QCPRange(left_bottom.y(), right_top.y()));
     color_map->setTightBoundary(true);
-    qreal dx, dy;
-
-    // set heights
-    QPoint cur{0, 0};
-    for (cur.ry() = 0; cur.y() < resolution.height(); ++cur.ry()) {
-        for (cur.rx() = 0; cur.x() < resolution.width(); ++cur.rx()) {
-            color_map->data()->cellToCoord(cur.x(), cur.y(), &dx, &dy);
-            color_map->data()->setCell(cur.x(), cur.y(), f(dx, dy));
-        }
-    }
+    // no mipmapping: both fillers pick a level of their grid with about one cell per pixel
 
     //set gradient
     QCPColorScale* color_scale = new QCPColorScale(&plot);
@@ -99,7 +147,6 @@ void MainWindow::set_color_map(QPointF const& left_bottom, QPointF const& right_
 
 
     color_map->setColorScale(color_scale);
-    color_map->rescaleDataRange();
 
     QCPColorGradient grad(QCPColorGradient::gpCold);
     grad.setLevelCount(17);
@@ -109,7 +156,32 @@ void MainWindow::set_color_map(QPointF const& left_bottom, QPointF const& right_
     QCPMarginGroup *marginGroup = new QCPMarginGroup(&plot);
     plot.axisRect()->setMarginGroup(QCP::msBottom|QCP::msTop, marginGroup);
     color_scale->setMarginGroup(QCP::msBottom|QCP::msTop, marginGroup);
-    color_map->rescaleAxes();
+    plot.xAxis->setRange(left_bottom.x(), right_top.x());
+    plot.yAxis->setRange(left_bottom.y(), right_top.y());
+
+    // iso-lines at the borders of the 17 color levels, which are hard to tell apart
+    new contour_layer(color_map, plot.layer("contours"), f);
+
+    // children of the color map: the visible part is read from the file or computed as the view changes
+    if (!surface_path.isEmpty()) {
+        auto surface = new mapped_surface(color_map, surface_path);
+        if (surface->ok()) {
+            return;
+        }
+        qDebug() << "can't read surface" << surface_path;
+        delete surface;
+    }
+    new loss_surface(color_map, f);
+}
+
+static QVector<QCPCurveData> to_curve_data(v<way_point> const& way)
+{
+    QVector<QCPCurveData> result;
+    result.reserve(static_cast<int>(way.size()));
+    for (auto const& elem : way) {
+        result.push_back({elem.t, elem.k, elem.b});
+    }
+    return result;
 }
 
 static QPen random_pen() {
@@ -135,12 +207,108 @@ static QPen random_pen() {
 //    return pen;
 }
 
-void MainWindow::make_way(v<QCPCurveData> const& way, QString const& name)
+void MainWindow::run_way(QString const& name, std::function<v<way_point>(way_observer const&)> optimizer)
+{
+    // the worker pushes at most one point per interval, whatever its step rate
+    static auto const push_interval = std::chrono::milliseconds(1);
+
+    QPointer<QCPCurve> curve = make_way({}, name);
+    auto queue = std::make_shared<spsc_queue<way_point>>(4096);
+    size_t const index = live_ways.size();
+    live_ways.push_back({curve, queue});
+    ++running;
+
+    // posted whether the optimizer ran, stopped early or was skipped, so running always drops to 0
+    auto finish = [this, name, index](v<way_point> way, long long const ms) {
+        auto pyramid = std::make_shared<way_pyramid>(std::move(way));
+        QMetaObject::invokeMethod(this, [this, name, index, ms, pyramid] {
+            // drop the preview points still queued, the decimated full way replaces them
+            for (way_point point; live_ways[index].queue->try_pop(point); ) {}
+            live_ways[index].pyramid = pyramid;
+            refresh_ways();
+            if (live_ways[index].curve) {
+                playback->add(pyramid, live_ways[index].curve->pen());
+            }
+            if (pyramid->full().empty()) {
+                qDebug() << name << "cancelled";
+            } else {
+                qDebug() << name << pyramid->full().size() - 1 << "steps" << ms << "ms";
+            }
+            if (--running == 0) {
+                drain_timer.stop();
+                METRICS_DUMP("metrics.json");
+            }
+        }, Qt::QueuedConnection);
+    };
+
+    jobs.submit([this, optimizer, queue, finish] {
+        auto const started = std::chrono::steady_clock::now();
+        auto pushed = started - push_interval;
+        auto way = optimizer([this, &queue, &pushed](way_point const& point) {
+            auto const now = std::chrono::steady_clock::now();
+            // a full queue only means a coarser preview, the whole way is sent at the end
+            if (now - pushed >= push_interval && queue->try_push(point)) {
+                pushed = now;
+            }
+            return !jobs.cancelled();
+        });
+        finish(std::move(way), std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - started).count());
+    }, [finish] { finish({}, 0); });
+}
+
+void MainWindow::refresh_ways()
+{
+    // half a pixel of error is invisible, more is tolerated while frames are slow
+    qreal const k_tolerance = lod_pixels * plot.xAxis->range().size() / std::max(1, plot.xAxis->axisRect()->width());
+    qreal const b_tolerance = lod_pixels * plot.yAxis->range().size() / std::max(1, plot.yAxis->axisRect()->height());
+    bool changed = false;
+    for (auto& elem : live_ways) {
+        if (!elem.pyramid || !elem.curve) {
+            continue;
+        }
+        int const level = elem.pyramid->level_index(k_tolerance, b_tolerance);
+        if (level != elem.level) {
+            elem.level = level;
+            elem.curve->data()->set(to_curve_data(elem.pyramid->level(level)), true);
+            changed = true;
+        }
+    }
+    // levels change only when zooming by a factor of two or with the quality, a view change replots everything anyway
+    if (changed) {
+        request_replot(&plot, ways_layer);
+    }
+}
+
+void MainWindow::drain_ways()
+{
+    bool changed = false;
+    QVector<QCPCurveData> points;
+    for (auto const& elem : live_ways) {
+        points.clear();
+        for (way_point point; elem.queue->try_pop(point); ) {
+            points.push_back({point.t, point.k, point.b});
+        }
+        if (elem.curve && !points.isEmpty()) {
+            elem.curve->data()->add(points, true);
+            changed = true;
+        }
+    }
+    // the view is unchanged, only the ways need repainting
+    if (changed) {
+        request_replot(&plot, ways_layer);
+    }
+}
+
+QCPCurve* MainWindow::make_way(v<way_point> const& way, QString const& name)
 {
     QCPCurve *curve = new QCPCurve(plot.xAxis, plot.yAxis);
+    curve->setLayer(ways_layer);
     curve->setPen(random_pen());
     curve->setName(name);
-    curve->data()->set(way, true);
+    // converging ways circle around the optimum, most of their points share a pixel
+    curve->setAdaptiveSampling(true);
+    curve->data()->set(to_curve_data(way), true);
 //    plot.addGraph();
 //    plot.graph()->addData(way[0].key, way[0].value);
 //    plot.graph()->setName("Start");
@@ -158,6 +326,7 @@ void MainWindow::make_way(v<QCPCurveData> const& way, QString const& name)
 //    QCPScatterStyle sc_end(QCPScatterStyle::ssTriangle);
 //    sc_end.setPen(QPen(QBrush(Qt::red),2));
 //    plot.graph()->setScatterStyle(sc_end);
+    return curve;
 }
 
 void MainWindow::set_points(const way_t &points, QString const& name)
@@ -188,14 +357,3 @@ void MainWindow::set_line(const qreal k, const qreal b, QString const& name)
     plot.graph()->setName(name);
 }
 
-
-way_t get_points_by_line(int n, const qreal k, const qreal b, const qreal x_min, const qreal x_max, const qreal delta)
-{
-    way_t points;
-    qreal x_temp;
-    while (n-- > 0) {
-        x_temp = random(x_min, x_max, 5);
-        points.emplace_back(x_temp, k * x_temp + b + random(-delta, delta, 5));
-    }
-    return points;
-}
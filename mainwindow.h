@@ -2,9 +2,17 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QPointer>
+#include <QTimer>
+#include <memory>
 #include <utility>
 #include "qcustomplot.h"
 #include "algos.h"
+#include "decimate.h"
+#include "replot_scheduler.h"
+#include "spsc_queue.h"
+#include "way_playback.h"
+#include "thread_pool.h"
 
 class MainWindow : public QMainWindow
 {
@@ -15,17 +23,45 @@ public:
 
 private:
     void start();
+    void setup_layers();
 
-    void set_color_map(QPointF const& left_bottom, QPointF const& right_top,
-                                   QSize const& resolution,
-                       auto const& f);
-    void make_way(v<QCPCurveData>const& way, QString const& name);
+    void set_color_map(QPointF const& left_bottom, QPointF const& right_top, auto const& f, QString const& surface_path);
+    // run the optimizer in background, streaming its trajectory into a new curve
+    void run_way(QString const& name, std::function<v<way_point>(way_observer const&)> optimizer);
+    void drain_ways();
+    // show every finished way at the level of detail of the current pixel size
+    void refresh_ways();
+    QCPCurve* make_way(v<way_point> const& way, QString const& name);
     void set_points(way_t const& points, QString const& name);
     void set_line(qreal const k, qreal const b, QString const& name);
 
     QCustomPlot plot;
-};
+    QPointer<QCPColorMap> color_map;
+    // buffered: trajectories and markers are repainted without the color map and the axes
+    QCPLayer* ways_layer = nullptr;
+    QCPLayer* markers_layer = nullptr;
+    way_playback* playback = nullptr;
+    // replots of every producer go through it
+    replot_scheduler* scheduler = nullptr;
+    // error of the shown ways in pixels, larger while the scheduler has reduced quality
+    qreal lod_pixels = 0.5;
+
+    struct live_way {
+        QPointer<QCPCurve> curve;
+        std::shared_ptr<spsc_queue<way_point>> queue;
+        // set once the optimizer has finished
+        std::shared_ptr<way_pyramid> pyramid;
+        int level = -1;
+    };
+    v<live_way> live_ways;
+    int running = 0;
+    QTimer drain_timer;
 
-way_t get_points_by_line(int n, qreal const k, qreal const b, qreal const x_min, qreal const x_max, qreal const delta);
+    // one thread per optimizer: they run for seconds and would hold the shared pool
+    // away from the tiles of the surface and the contours
+    thread_pool optimizer_pool{5};
+    // background work posting to this window; declared last so it is cancelled and joined first
+    task_group jobs{optimizer_pool};
+};
 
 #endif // MAINWINDOW_H
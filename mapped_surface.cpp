@@ -0,0 +1,157 @@
+#include "mapped_surface.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+mapped_surface::mapped_surface(QCPColorMap* color_map, QString const& path)
+    : QObject(color_map), color_map(color_map), file(path)
+{
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(surface_header))) {
+        return;
+    }
+    uchar const* mapped = file.map(0, file.size());
+    if (!mapped) {
+        return;
+    }
+    std::memcpy(&header, mapped, sizeof(header));
+    if (!surface_valid(header, static_cast<uint64_t>(file.size()))) {
+        file.unmap(const_cast<uchar*>(mapped));
+        return;
+    }
+    samples = mapped;
+    levels = surface_levels(header);
+
+    QCPColorGradient grad = color_map->gradient();
+    grad.setNanHandling(QCPColorGradient::nhTransparent);
+    color_map->setGradient(grad);
+    // the writer recorded the bounds, no need to look at the cells
+    if (header.lower < header.upper) {
+        color_map->setDataRange({header.lower, header.upper});
+    }
+
+    connect(color_map->keyAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &mapped_surface::schedule_update);
+    connect(color_map->valueAxis(), QOverload<QCPRange const&>::of(&QCPAxis::rangeChanged), this, &mapped_surface::schedule_update);
+    connect(color_map->parentPlot(), &QCustomPlot::afterLayout, this, &mapped_surface::schedule_update);
+    schedule_update();
+}
+
+mapped_surface::~mapped_surface()
+{
+    jobs.cancel();
+    jobs.wait();
+}
+
+void mapped_surface::schedule_update()
+{
+    if (!update_queued) {
+        update_queued = true;
+        QMetaObject::invokeMethod(this, [this] { update(); }, Qt::QueuedConnection);
+    }
+}
+
+// indices of the cells from the one centered at or before lower to the one centered at or after upper,
+// so interpolation reaches the view borders; false if no cell is in [lower, upper]
+static bool visible_cells(double const lower, double const upper, double const min, double const step, uint64_t const count,
+                          uint64_t& first, uint64_t& last)
+{
+    double const a = std::floor((lower - min) / step - 0.5);
+    double const b = std::ceil((upper - min) / step - 0.5);
+    if (b < 0 || a > static_cast<double>(count - 1)) {
+        return false;
+    }
+    first = a < 0 ? 0 : static_cast<uint64_t>(a);
+    last = std::min(static_cast<uint64_t>(b), count - 1);
+    return true;
+}
+
+void mapped_surface::update()
+{
+    update_queued = false;
+    if (!color_map || !samples) {
+        return;
+    }
+
+    QCPRange const key_range = color_map->keyAxis()->range();
+    QCPRange const value_range = color_map->valueAxis()->range();
+    QRect const rect = color_map->keyAxis()->axisRect()->rect();
+    if (rect.width() <= 0 || rect.height() <= 0) {
+        return;
+    }
+    // afterLayout fires on every replot, so most updates find nothing new
+    if (key_range == last_key_range && value_range == last_value_range && rect == last_rect) {
+        return;
+    }
+    last_key_range = key_range;
+    last_value_range = value_range;
+    last_rect = rect;
+
+    // coarsest level with at least one cell per pixel along both axes
+    double const key_per_pixel = key_range.size() / rect.width();
+    double const value_per_pixel = value_range.size() / rect.height();
+    size_t l = 0;
+    while (l + 1 < levels.size() && levels[l + 1].step_x <= key_per_pixel && levels[l + 1].step_y <= value_per_pixel) {
+        ++l;
+    }
+    surface_level const& level = levels[l];
+    uint64_t x0, x1, y0, y1;
+    if (!visible_cells(key_range.lower, key_range.upper, header.x_min, level.step_x, level.width, x0, x1)
+            || !visible_cells(value_range.lower, value_range.upper, header.y_min, level.step_y, level.height, y0, y1)) {
+        return;
+    }
+
+    // only the latest view is extracted and shown
+    uint64_t const current = ++generation;
+    jobs.submit([this, l, x0, x1, y0, y1, current] {
+        if (generation != current) {
+            return;
+        }
+        auto data = extract(l, x0, x1, y0, y1);
+        QMetaObject::invokeMethod(this, [this, data, current] {
+            if (generation != current || !color_map) {
+                return;
+            }
+            color_map->setData(data.get(), true);
+            request_replot(color_map->parentPlot());
+        }, Qt::QueuedConnection);
+    });
+}
+
+std::shared_ptr<QCPColorMapData> mapped_surface::extract(size_t const l, uint64_t x0, uint64_t x1, uint64_t y0, uint64_t y1) const
+{
+    surface_level const& level = levels[l];
+    uint64_t const n = header.tile;
+    int const width = static_cast<int>(x1 - x0 + 1);
+    int const height = static_cast<int>(y1 - y0 + 1);
+    QCPRange const key_range(header.x_min + (static_cast<double>(x0) + 0.5) * level.step_x,
+                             header.x_min + (static_cast<double>(x1) + 0.5) * level.step_x);
+    QCPRange const value_range(header.y_min + (static_cast<double>(y0) + 0.5) * level.step_y,
+                               header.y_min + (static_cast<double>(y1) + 0.5) * level.step_y);
+
+    auto data = std::make_shared<QCPColorMapData>(width, height, key_range, value_range);
+    double* out = data->beginBulkWrite();
+    double lower = std::numeric_limits<double>::infinity();
+    double upper = -std::numeric_limits<double>::infinity();
+    float const* tiles = reinterpret_cast<float const*>(samples + level.offset);
+    for (uint64_t y = y0; y <= y1; ++y) {
+        // the part of a row inside one tile is contiguous in the file
+        for (uint64_t x = x0; x <= x1; ) {
+            uint64_t const tx = x / n;
+            uint64_t const end = std::min(x1 + 1, (tx + 1) * n);
+            float const* row = tiles + ((y / n * level.tiles_x + tx) * n + y % n) * n;
+            for (; x < end; ++x) {
+                double const z = row[x % n];
+                *out++ = z;
+                // NaN fails both comparisons
+                lower = z < lower ? z : lower;
+                upper = z > upper ? z : upper;
+            }
+        }
+    }
+    if (lower <= upper) {
+        data->endBulkWrite({lower, upper});
+    } else {
+        data->endBulkWrite();
+    }
+    return data;
+}
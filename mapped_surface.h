@@ -0,0 +1,52 @@
+#ifndef MAPPED_SURFACE_H
+#define MAPPED_SURFACE_H
+
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include <memory>
+#include "qcustomplot.h"
+#include "replot_scheduler.h"
+#include "surface_file.h"
+#include "thread_pool.h"
+
+// keeps a QCPColorMap filled from a memory-mapped surface file (see surface_file.h): only the cells
+// within the visible axis ranges are read, from the coarsest level still having a cell per pixel,
+// so the pages touched depend on the view and not on the size of the surface
+class mapped_surface : public QObject
+{
+    Q_OBJECT
+
+public:
+    mapped_surface(QCPColorMap* color_map, QString const& path);
+    ~mapped_surface() override;
+
+    // false if the file can't be mapped or isn't a surface file
+    bool ok() const {
+        return samples != nullptr;
+    }
+
+private:
+    // coalesce range changes into one update per event loop iteration
+    void schedule_update();
+    void update();
+    // cells [x0, x1] x [y0, y1] of a level, reading only the tiles they intersect
+    std::shared_ptr<QCPColorMapData> extract(size_t const l, uint64_t x0, uint64_t x1, uint64_t y0, uint64_t y1) const;
+
+    QPointer<QCPColorMap> color_map;
+    QFile file;
+    uchar const* samples = nullptr;
+    surface_header header;
+    v<surface_level> levels;
+    std::atomic<uint64_t> generation{0};
+    bool update_queued = false;
+    QCPRange last_key_range;
+    QCPRange last_value_range;
+    QRect last_rect;
+
+    // declared last: cancelled and joined before the mapping is released
+    task_group jobs;
+};
+
+#endif // MAPPED_SURFACE_H
@@ -0,0 +1,104 @@
+#include "metrics.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace metrics {
+
+registry& registry::instance()
+{
+    static registry result;
+    return result;
+}
+
+template<typename T>
+static T& get_or_create(std::map<std::string, std::unique_ptr<T>>& entries, std::string const& name)
+{
+    auto& entry = entries[name];
+    if (!entry) {
+        entry = std::make_unique<T>();
+    }
+    return *entry;
+}
+
+timer_stat& registry::timer(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return get_or_create(timers, name);
+}
+
+counter_t& registry::counter(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return get_or_create(counters, name);
+}
+
+gauge_t& registry::gauge(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return get_or_create(gauges, name);
+}
+
+void registry::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& elem : timers) {
+        elem.second->ns = 0;
+        elem.second->calls = 0;
+    }
+    for (auto& elem : counters) {
+        *elem.second = 0;
+    }
+    for (auto& elem : gauges) {
+        *elem.second = 0;
+    }
+}
+
+void registry::dump_json(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    char const* sep = "";
+
+    out << "{\n  \"timers\": {";
+    for (auto const& elem : timers) {
+        long long const ns = elem.second->ns.load();
+        long long const calls = elem.second->calls.load();
+        out << sep << "\n    \"" << elem.first << "\": {\"calls\": " << calls
+            << ", \"total_ns\": " << ns
+            << ", \"mean_ns\": " << (calls == 0 ? 0 : ns / calls) << "}";
+        sep = ",";
+    }
+
+    sep = "";
+    out << "\n  },\n  \"counters\": {";
+    for (auto const& elem : counters) {
+        out << sep << "\n    \"" << elem.first << "\": " << elem.second->load();
+        sep = ",";
+    }
+
+    sep = "";
+    out << "\n  },\n  \"gauges\": {";
+    for (auto const& elem : gauges) {
+        double const value = elem.second->load();
+        out << sep << "\n    \"" << elem.first << "\": ";
+        if (std::isfinite(value)) {
+            out << std::setprecision(17) << value;
+        } else {
+            out << "null";
+        }
+        sep = ",";
+    }
+    out << "\n  }\n}\n";
+}
+
+bool registry::dump_json(std::string const& path) const
+{
+    std::ofstream fout(path);
+    if (!fout) {
+        return false;
+    }
+    dump_json(fout);
+    return static_cast<bool>(fout);
+}
+
+} // namespace metrics
@@ -0,0 +1,147 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// build with -DMETRICS_ENABLED=1 to collect timers, counters and gauges,
+// otherwise every METRICS_* macro expands to nothing
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 0
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace metrics {
+
+using counter_t = std::atomic<long long>;
+using gauge_t = std::atomic<double>;
+
+struct timer_stat {
+    std::atomic<long long> ns{0};
+    std::atomic<long long> calls{0};
+};
+
+// named timers, counters and gauges; entries are never removed, so references stay valid
+class registry {
+public:
+    static registry& instance();
+
+    timer_stat& timer(std::string const& name);
+    counter_t& counter(std::string const& name);
+    gauge_t& gauge(std::string const& name);
+
+    // zero all values, keep entries
+    void reset();
+
+    void dump_json(std::ostream& out) const;
+    bool dump_json(std::string const& path) const;
+
+private:
+    registry() = default;
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::unique_ptr<timer_stat>> timers;
+    std::map<std::string, std::unique_ptr<counter_t>> counters;
+    std::map<std::string, std::unique_ptr<gauge_t>> gauges;
+};
+
+class scoped_timer {
+public:
+    explicit scoped_timer(timer_stat& stat) noexcept
+        : stat(stat), started(std::chrono::steady_clock::now()) {}
+
+    ~scoped_timer() {
+        auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+        stat.ns.fetch_add(ns, std::memory_order_relaxed);
+        stat.calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    scoped_timer(scoped_timer const&) = delete;
+    scoped_timer& operator=(scoped_timer const&) = delete;
+
+private:
+    timer_stat& stat;
+    std::chrono::steady_clock::time_point started;
+};
+
+// times one call in sample_every, counted as sample_every calls of that duration: the clock
+// isn't read around every step, yet totals and means stay unbiased
+class sampled_timer {
+public:
+    static unsigned const sample_every = 64;
+
+    sampled_timer(timer_stat& stat, unsigned& tick) noexcept
+        : stat(stat), active(tick++ % sample_every == 0)
+    {
+        if (active) {
+            started = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~sampled_timer() {
+        if (!active) {
+            return;
+        }
+        auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+        stat.ns.fetch_add(ns * sample_every, std::memory_order_relaxed);
+        stat.calls.fetch_add(sample_every, std::memory_order_relaxed);
+    }
+
+    sampled_timer(sampled_timer const&) = delete;
+    sampled_timer& operator=(sampled_timer const&) = delete;
+
+private:
+    timer_stat& stat;
+    bool const active;
+    std::chrono::steady_clock::time_point started;
+};
+
+} // namespace metrics
+
+#define METRICS_CAT_(a, b) a##b
+#define METRICS_CAT(a, b) METRICS_CAT_(a, b)
+
+#if METRICS_ENABLED
+
+// time the rest of the enclosing scope; the registry lookup happens once per call site
+#define METRICS_SCOPE(name) \
+    static metrics::timer_stat& METRICS_CAT(metrics_stat_, __LINE__) = metrics::registry::instance().timer(name); \
+    metrics::scoped_timer METRICS_CAT(metrics_timer_, __LINE__)(METRICS_CAT(metrics_stat_, __LINE__))
+
+// METRICS_SCOPE for scopes entered once per step: only a sample of the calls is timed
+#define METRICS_SAMPLED_SCOPE(name) \
+    static metrics::timer_stat& METRICS_CAT(metrics_stat_, __LINE__) = metrics::registry::instance().timer(name); \
+    static thread_local unsigned METRICS_CAT(metrics_tick_, __LINE__) = 0; \
+    metrics::sampled_timer METRICS_CAT(metrics_timer_, __LINE__)(METRICS_CAT(metrics_stat_, __LINE__), METRICS_CAT(metrics_tick_, __LINE__))
+
+#define METRICS_COUNT(name, n) \
+    do { \
+        static metrics::counter_t& metrics_counter = metrics::registry::instance().counter(name); \
+        metrics_counter.fetch_add((n), std::memory_order_relaxed); \
+    } while (0)
+
+#define METRICS_GAUGE(name, value) \
+    do { \
+        static metrics::gauge_t& metrics_gauge = metrics::registry::instance().gauge(name); \
+        metrics_gauge.store((value), std::memory_order_relaxed); \
+    } while (0)
+
+#define METRICS_DUMP(path) metrics::registry::instance().dump_json(std::string(path))
+
+#else
+
+#define METRICS_SCOPE(name) do {} while (0)
+#define METRICS_SAMPLED_SCOPE(name) do {} while (0)
+#define METRICS_COUNT(name, n) do {} while (0)
+#define METRICS_GAUGE(name, value) do {} while (0)
+#define METRICS_DUMP(path) do {} while (0)
+
+#endif
+
+#endif // METRICS_H
@@ -0,0 +1,80 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "thread_pool.h"
+
+// number of workers used when a caller passes threads == 0
+inline unsigned default_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// call f(i) for every i from [0, count) on up to `threads` threads of the global pool, the caller included;
+// indices are handed out dynamically and the caller works too, so nesting inside pool tasks can't deadlock.
+// If f throws, the indices not yet started are skipped and the first exception is rethrown once no
+// thread calls f anymore
+template<typename F>
+void parallel_for(size_t const count, F const& f, unsigned threads = 0)
+{
+    if (threads == 0) {
+        threads = default_threads();
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            f(i);
+        }
+        return;
+    }
+
+    struct state {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+    };
+    // helpers may start after the caller has returned: they find no indices left and never touch f
+    auto shared = std::make_shared<state>();
+    auto work = [shared, &f, count] {
+        for (size_t i; (i = shared->next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+            if (!shared->failed.load(std::memory_order_relaxed)) {
+                try {
+                    f(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(shared->mutex);
+                    if (!shared->error) {
+                        shared->error = std::current_exception();
+                    }
+                    shared->failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            // counted even when failed or skipped, so the caller's wait always ends
+            if (shared->done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->cv.notify_all();
+            }
+        }
+    };
+
+    for (unsigned i = 1; i < threads; ++i) {
+        thread_pool::global().submit(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->cv.wait(lock, [&shared, count] { return shared->done.load(std::memory_order_acquire) == count; });
+    if (shared->error) {
+        std::rethrow_exception(shared->error);
+    }
+}
+
+#endif // PARALLEL_H
@@ -25,6 +25,15 @@
 
 #include "qcustomplot.h"
 
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+#include <functional>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
 
 /* including file 'src/vector2d.cpp'       */
 /* modified 2022-11-06T12:45:56, size 7973 */
@@ -16688,6 +16697,202 @@ void QCPColorGradient::setPeriodic(bool enabled)
   mPeriodic = enabled;
 }
 
+/*! \internal
+
+  Returns the value of a cell stored as \a quantized in the \ref QCPColorMapData::smQuantized16
+  storage mode, with quantization levels \a step apart starting at \a lower. The maximum code 65535
+  stands for NaN.
+*/
+static inline double qcpDequantize(quint16 quantized, double lower, double step)
+{
+  return quantized == 65535 ? std::numeric_limits<double>::quiet_NaN() : lower + quantized*step;
+}
+
+/*! \internal
+
+  Colorizes compact \a data with \a gradient, for the float and quantized \ref
+  QCPColorGradient::colorize overloads: blocks of values are converted with \a decode into a
+  buffer on the stack and passed on to the double overloads.
+*/
+template <typename T, typename Decode>
+static void qcpColorizeDecoded(QCPColorGradient *gradient, const T *data, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic, Decode decode)
+{
+  const int blockSize = 256;
+  double values[blockSize];
+  unsigned char alphas[blockSize];
+  for (int begin=0; begin<n; begin+=blockSize)
+  {
+    const int count = qMin(blockSize, n-begin);
+    for (int i=0; i<count; ++i)
+      values[i] = decode(data[dataIndexFactor*(begin+i)]);
+    if (alpha)
+    {
+      for (int i=0; i<count; ++i)
+        alphas[i] = alpha[dataIndexFactor*(begin+i)];
+      gradient->colorize(values, alphas, range, scanLine+begin, count, 1, logarithmic);
+    } else
+      gradient->colorize(values, range, scanLine+begin, count, 1, logarithmic);
+  }
+}
+
+/*! \internal
+
+  Maps \a n contiguous \a positions to colors of the non-periodic gradient \a colors, which has \a
+  maxIndex+1 levels, as <tt>colors[qBound(0, int((positions[i]-offset)*factor), maxIndex)]</tt>.
+  If \a nanCheck is set, elements whose \a values entry is NaN get \a nanColor instead. If \a alpha
+  is not null, the colors of the other elements are premultiplied with it.
+
+  Positions are clamped before they are truncated, so +inf and positions of 2^63 and above get the
+  highest color. The qint64 cast the colorize overloads used before was undefined for them and gave
+  the lowest color on x86; all other positions, NaN and -inf included, map as before.
+
+  Used by both \ref QCPColorGradient::colorize overloads. The result is identical to their scalar
+  loop, the bulk is processed four values at a time with AVX2 (gathering from \a colors) or with SSE2
+  index computation and scalar lookups, depending on the instruction set the library is compiled for.
+*/
+static void qcpColorizeClamped(const double *values, const double *positions, double offset, double factor, const unsigned char *alpha, QRgb *scanLine, int n, const QRgb *colors, int maxIndex, bool nanCheck, QRgb nanColor)
+{
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256d vOffset = _mm256_set1_pd(offset);
+  const __m256d vFactor = _mm256_set1_pd(factor);
+  const __m256d vZero = _mm256_setzero_pd();
+  const __m256d vMaxIndex = _mm256_set1_pd(maxIndex);
+  const __m128 v255 = _mm_set1_ps(255.0f);
+  const __m256i lowPixels = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+  const __m256i highPixels = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+  for (; i+4 <= n; i += 4)
+  {
+    const __m256d position = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(positions+i), vOffset), vFactor);
+    // clamping before truncation gives the same index as truncating first; max with zero also maps NaN to 0
+    const __m128i index = _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(position, vZero), vMaxIndex));
+    __m128i rgb = _mm_i32gather_epi32(reinterpret_cast<const int*>(colors), index, 4);
+    if (alpha)
+    {
+      int alphaBytes;
+      memcpy(&alphaBytes, alpha+i, sizeof(alphaBytes));
+      if (alphaBytes != -1) // all four 255 needs no premultiplication
+      {
+        const __m128 alphaF = _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(alphaBytes))), v255);
+        const __m256 alphaLow = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(alphaF), lowPixels);
+        const __m256 alphaHigh = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(alphaF), highPixels);
+        const __m256i channelsLow = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(rgb)), alphaLow));
+        const __m256i channelsHigh = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(rgb, 8))), alphaHigh));
+        // packing works per 128 bit lane: the low lane holds pixels 0 and 2, the high lane pixels 1 and 3
+        __m256i packed = _mm256_packus_epi32(channelsLow, channelsHigh);
+        packed = _mm256_packus_epi16(packed, packed);
+        rgb = _mm_unpacklo_epi32(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+      }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(scanLine+i), rgb);
+    if (nanCheck)
+    {
+      const __m256d value = _mm256_loadu_pd(values+i);
+      const int nanBits = _mm256_movemask_pd(_mm256_cmp_pd(value, value, _CMP_UNORD_Q));
+      for (int k=0; nanBits && k<4; ++k)
+      {
+        if (nanBits & (1 << k))
+          scanLine[i+k] = nanColor;
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128d vOffset = _mm_set1_pd(offset);
+  const __m128d vFactor = _mm_set1_pd(factor);
+  const __m128d vZero = _mm_setzero_pd();
+  const __m128d vMaxIndex = _mm_set1_pd(maxIndex);
+  for (; i+4 <= n; i += 4)
+  {
+    const __m128d position01 = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(positions+i), vOffset), vFactor);
+    const __m128d position23 = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(positions+i+2), vOffset), vFactor);
+    // clamping before truncation gives the same index as truncating first; max with zero also maps NaN to 0
+    const __m128i index01 = _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(position01, vZero), vMaxIndex));
+    const __m128i index23 = _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(position23, vZero), vMaxIndex));
+    int index[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(index), _mm_unpacklo_epi64(index01, index23));
+    for (int k=0; k<4; ++k)
+      scanLine[i+k] = colors[index[k]];
+    if (alpha)
+    {
+      for (int k=0; k<4; ++k)
+      {
+        if (alpha[i+k] != 255)
+        {
+          const QRgb rgb = scanLine[i+k];
+          const float alphaF = alpha[i+k]/255.0f;
+          scanLine[i+k] = qRgba(int(qRed(rgb)*alphaF), int(qGreen(rgb)*alphaF), int(qBlue(rgb)*alphaF), int(qAlpha(rgb)*alphaF));
+        }
+      }
+    }
+    if (nanCheck)
+    {
+      const __m128d value01 = _mm_loadu_pd(values+i);
+      const __m128d value23 = _mm_loadu_pd(values+i+2);
+      const int nanBits = _mm_movemask_pd(_mm_cmpunord_pd(value01, value01)) | _mm_movemask_pd(_mm_cmpunord_pd(value23, value23)) << 2;
+      for (int k=0; nanBits && k<4; ++k)
+      {
+        if (nanBits & (1 << k))
+          scanLine[i+k] = nanColor;
+      }
+    }
+  }
+#endif
+  for (; i<n; ++i)
+  {
+    if (nanCheck && std::isnan(values[i]))
+    {
+      scanLine[i] = nanColor;
+      continue;
+    }
+    const double position = (positions[i]-offset)*factor;
+    const int index = !(position > 0) ? 0 : (position < maxIndex ? int(position) : maxIndex);
+    QRgb rgb = colors[index];
+    if (alpha && alpha[i] != 255)
+    {
+      const float alphaF = alpha[i]/255.0f;
+      rgb = qRgba(int(qRed(rgb)*alphaF), int(qGreen(rgb)*alphaF), int(qBlue(rgb)*alphaF), int(qAlpha(rgb)*alphaF));
+    }
+    scanLine[i] = rgb;
+  }
+}
+
+/*! \internal
+
+  Non-periodic path of the \ref QCPColorGradient::colorize overloads: strided data, and the
+  logarithm for \a logarithmic ranges, is prepared in blocks on the stack and passed to \ref
+  qcpColorizeClamped. Contiguous linear data is passed directly.
+*/
+static void qcpColorizeBlocks(const double *data, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic, double posToIndexFactor, const QRgb *colors, int maxIndex, bool nanCheck, QRgb nanColor)
+{
+  if (dataIndexFactor == 1 && !logarithmic)
+  {
+    qcpColorizeClamped(data, data, range.lower, posToIndexFactor, alpha, scanLine, n, colors, maxIndex, nanCheck, nanColor);
+    return;
+  }
+  const int blockSize = 256;
+  double values[blockSize];
+  double positions[blockSize];
+  unsigned char alphas[blockSize];
+  for (int begin=0; begin<n; begin+=blockSize)
+  {
+    const int count = qMin(blockSize, n-begin);
+    for (int i=0; i<count; ++i)
+      values[i] = data[dataIndexFactor*(begin+i)];
+    if (alpha)
+    {
+      for (int i=0; i<count; ++i)
+        alphas[i] = alpha[dataIndexFactor*(begin+i)];
+    }
+    if (logarithmic)
+    {
+      for (int i=0; i<count; ++i)
+        positions[i] = qLn(values[i]/range.lower);
+    }
+    qcpColorizeClamped(values, logarithmic ? positions : values, logarithmic ? 0.0 : range.lower, posToIndexFactor, alpha ? alphas : nullptr,
+                       scanLine+begin, count, colors, maxIndex, nanCheck, nanColor);
+  }
+}
+
 /*! \overload
   
   This method is used to quickly convert a \a data array to colors. The colors will be output in
@@ -16724,6 +16929,11 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
   
   const bool skipNanCheck = mNanHandling == nhNone;
   const double posToIndexFactor = !logarithmic ? (mLevelCount-1)/range.size() : (mLevelCount-1)/qLn(range.upper/range.lower);
+  if (!mPeriodic)
+  {
+    qcpColorizeBlocks(data, nullptr, range, scanLine, n, dataIndexFactor, logarithmic, posToIndexFactor, mColorBuffer.constData(), mLevelCount-1, !skipNanCheck, nanColorRgb());
+    return;
+  }
   for (int i=0; i<n; ++i)
   {
     const double value = data[dataIndexFactor*i];
@@ -16785,6 +16995,11 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
   
   const bool skipNanCheck = mNanHandling == nhNone;
   const double posToIndexFactor = !logarithmic ? (mLevelCount-1)/range.size() : (mLevelCount-1)/qLn(range.upper/range.lower);
+  if (!mPeriodic)
+  {
+    qcpColorizeBlocks(data, alpha, range, scanLine, n, dataIndexFactor, logarithmic, posToIndexFactor, mColorBuffer.constData(), mLevelCount-1, !skipNanCheck, nanColorRgb());
+    return;
+  }
   for (int i=0; i<n; ++i)
   {
     const double value = data[dataIndexFactor*i];
@@ -16823,6 +17038,52 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
   }
 }
 
+/*! \overload
+
+  Colorizes \a data stored in single precision, as held by \ref QCPColorMapData in the \ref
+  QCPColorMapData::smFloat storage mode. \a alpha may be \c nullptr for full opacity. Otherwise
+  this works like the overloads for double data, which are used on small blocks of converted
+  values.
+*/
+void QCPColorGradient::colorize(const float *data, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+{
+  if (!data)
+  {
+    qDebug() << Q_FUNC_INFO << "null pointer given as data";
+    return;
+  }
+  if (!scanLine)
+  {
+    qDebug() << Q_FUNC_INFO << "null pointer given as scanLine";
+    return;
+  }
+  qcpColorizeDecoded(this, data, alpha, range, scanLine, n, dataIndexFactor, logarithmic, [](float value) { return double(value); });
+}
+
+/*! \overload
+
+  Colorizes quantized \a data, as held by \ref QCPColorMapData in the \ref
+  QCPColorMapData::smQuantized16 storage mode: the codes 0 to 65534 are spread evenly over \a
+  quantizationRange, 65535 means NaN. \a alpha may be \c nullptr for full opacity. Otherwise this
+  works like the overloads for double data, which are used on small blocks of converted values.
+*/
+void QCPColorGradient::colorize(const quint16 *data, const QCPRange &quantizationRange, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor, bool logarithmic)
+{
+  if (!data)
+  {
+    qDebug() << Q_FUNC_INFO << "null pointer given as data";
+    return;
+  }
+  if (!scanLine)
+  {
+    qDebug() << Q_FUNC_INFO << "null pointer given as scanLine";
+    return;
+  }
+  const double lower = quantizationRange.lower;
+  const double step = quantizationRange.size()/65534.0;
+  qcpColorizeDecoded(this, data, alpha, range, scanLine, n, dataIndexFactor, logarithmic, [lower, step](quint16 value) { return qcpDequantize(value, lower, step); });
+}
+
 /*! \internal
 
   This method is used to colorize a single data value given in \a position, to colors. The data
@@ -17020,6 +17281,25 @@ bool QCPColorGradient::stopsUseAlpha() const
   return false;
 }
 
+/*! \internal
+
+  Returns the color that NaN data values are mapped to according to \ref setNanHandling. Must only
+  be called with an up-to-date color buffer. For \ref nhNone, NaN values aren't treated specially
+  and the returned value is meaningless.
+*/
+QRgb QCPColorGradient::nanColorRgb() const
+{
+  switch(mNanHandling)
+  {
+  case nhLowestColor: return mColorBuffer.first();
+  case nhHighestColor: return mColorBuffer.last();
+  case nhTransparent: return qRgba(0, 0, 0, 0);
+  case nhNanColor: return mNanColor.rgba();
+  case nhNone: break;
+  }
+  return qRgba(0, 0, 0, 0);
+}
+
 /*! \internal
   
   Updates the internal color buffer which will be used by \ref colorize and \ref color, to quickly
@@ -22653,7 +22933,8 @@ QCPCurveData::QCPCurveData(double t, double key, double value) :
 QCPCurve::QCPCurve(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   QCPAbstractPlottable1D<QCPCurveData>(keyAxis, valueAxis),
   mScatterSkip{},
-  mLineStyle{}
+  mLineStyle{},
+  mAdaptiveSampling(false)
 {
   // modify inherited properties from abstract plottable:
   setPen(QPen(Qt::blue, 0));
@@ -22763,6 +23044,24 @@ void QCPCurve::setLineStyle(QCPCurve::LineStyle style)
   mLineStyle = style;
 }
 
+/*!
+  Sets whether adaptive sampling shall be used for the curve's line. If enabled, runs of
+  consecutive data points inside the visible axis rect that fall into the same device pixel are
+  merged: only the first and last point of the run and the points with extreme key and value pixel
+  coordinates are kept, in their original order. The drawn line thus stays within one pixel of the
+  full line, while the number of segments passed to the painter is bounded by the number of pixels
+  the curve passes through rather than by its data count.
+
+  This is useful for long parametric curves such as optimizer trajectories, which often revisit the
+  same pixels many times. Scatters are not affected. By default, adaptive sampling is disabled.
+
+  \see QCPGraph::setAdaptiveSampling
+*/
+void QCPCurve::setAdaptiveSampling(bool enabled)
+{
+  mAdaptiveSampling = enabled;
+}
+
 /*! \overload
   
   Adds the provided points in \a t, \a keys and \a values to the current data. The provided vectors
@@ -23037,6 +23336,79 @@ void QCPCurve::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &poin
       style.drawShape(painter,  point);
 }
 
+/*! \internal
+
+  Helper of \ref QCPCurve::getCurveLines for adaptive sampling (\ref QCPCurve::setAdaptiveSampling).
+  Collects consecutive pixel points lying in the same device pixel and, once the run ends, appends
+  its first and last point and its extreme points to the output, in their original order.
+*/
+class QCPCurvePixelSampler
+{
+public:
+  explicit QCPCurvePixelSampler(QVector<QPointF> *lines) :
+    mLines(lines),
+    mCount(0),
+    mCellX(0),
+    mCellY(0)
+  {
+  }
+  
+  void add(const QPointF &point)
+  {
+    if (qIsNaN(point.x()) || qIsNaN(point.y()))
+    {
+      flush();
+      mLines->append(point);
+      return;
+    }
+    const int cellX = qFloor(point.x());
+    const int cellY = qFloor(point.y());
+    if (mCount > 0 && cellX == mCellX && cellY == mCellY)
+    {
+      const Sample sample = {point, mCount++};
+      if (point.x() < mMinX.point.x()) mMinX = sample;
+      if (point.x() > mMaxX.point.x()) mMaxX = sample;
+      if (point.y() < mMinY.point.y()) mMinY = sample;
+      if (point.y() > mMaxY.point.y()) mMaxY = sample;
+      mLast = sample;
+      return;
+    }
+    flush();
+    const Sample sample = {point, mCount++};
+    mCellX = cellX;
+    mCellY = cellY;
+    mFirst = mLast = mMinX = mMaxX = mMinY = mMaxY = sample;
+  }
+  
+  void flush()
+  {
+    if (mCount == 0)
+      return;
+    Sample samples[] = {mFirst, mMinX, mMaxX, mMinY, mMaxY, mLast};
+    std::sort(std::begin(samples), std::end(samples), [](const Sample &a, const Sample &b) { return a.index < b.index; });
+    int previous = -1;
+    for (const Sample &sample : samples)
+    {
+      if (sample.index != previous)
+        mLines->append(sample.point);
+      previous = sample.index;
+    }
+    mCount = 0;
+  }
+  
+private:
+  struct Sample
+  {
+    QPointF point;
+    int index;
+  };
+  
+  QVector<QPointF> *mLines;
+  int mCount;
+  int mCellX, mCellY;
+  Sample mFirst, mLast, mMinX, mMaxX, mMinY, mMaxY;
+};
+
 /*! \internal
 
   Called by \ref draw to generate points in pixel coordinates which represent the line of the
@@ -23088,11 +23460,13 @@ void QCPCurve::getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRa
   QCPCurveDataContainer::const_iterator prevIt = itEnd-1;
   int prevRegion = getRegion(prevIt->key, prevIt->value, keyMin, valueMax, keyMax, valueMin);
   QVector<QPointF> trailingPoints; // points that must be applied after all other points (are generated only when handling first point to get virtual segment between last and first point right)
+  QCPCurvePixelSampler sampler(lines); // with adaptive sampling, points inside R are collected here, so it's flushed before anything else is appended
   while (it != itEnd)
   {
     const int currentRegion = getRegion(it->key, it->value, keyMin, valueMax, keyMax, valueMin);
     if (currentRegion != prevRegion) // changed region, possibly need to add some optimized edge points or original points if entering R
     {
+      sampler.flush();
       if (currentRegion != 5) // segment doesn't end in R, so it's a candidate for removal
       {
         QPointF crossA, crossB;
@@ -23129,13 +23503,19 @@ void QCPCurve::getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRa
           trailingPoints << getOptimizedPoint(prevRegion, prevIt->key, prevIt->value, it->key, it->value, keyMin, valueMax, keyMax, valueMin);
         else
           lines->append(getOptimizedPoint(prevRegion, prevIt->key, prevIt->value, it->key, it->value, keyMin, valueMax, keyMax, valueMin));
-        lines->append(coordsToPixels(it->key, it->value));
+        if (mAdaptiveSampling)
+          sampler.add(coordsToPixels(it->key, it->value));
+        else
+          lines->append(coordsToPixels(it->key, it->value));
       }
     } else // region didn't change
     {
       if (currentRegion == 5) // still in R, keep adding original points
       {
-        lines->append(coordsToPixels(it->key, it->value));
+        if (mAdaptiveSampling)
+          sampler.add(coordsToPixels(it->key, it->value));
+        else
+          lines->append(coordsToPixels(it->key, it->value));
       } else // still outside R, no need to add anything
       {
         // see how this is not doing anything? That's the main optimization...
@@ -23145,6 +23525,7 @@ void QCPCurve::getCurveLines(QVector<QPointF> *lines, const QCPDataRange &dataRa
     prevRegion = currentRegion;
     ++it;
   }
+  sampler.flush();
   *lines << trailingPoints;
 }
 
@@ -25851,8 +26232,14 @@ QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &key
   mKeyRange(keyRange),
   mValueRange(valueRange),
   mIsEmpty(true),
+  mStorageMode(smDouble),
+  mQuantizationRange(0, 1),
   mData(nullptr),
+  mFloatData(nullptr),
+  mQuantizedData(nullptr),
   mAlpha(nullptr),
+  mDataBoundsValid(true),
+  mDataBoundsExact(false),
   mDataModified(true)
 {
   setSize(keySize, valueSize);
@@ -25861,7 +26248,7 @@ QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &key
 
 QCPColorMapData::~QCPColorMapData()
 {
-  delete[] mData;
+  freeData();
   delete[] mAlpha;
 }
 
@@ -25872,8 +26259,14 @@ QCPColorMapData::QCPColorMapData(const QCPColorMapData &other) :
   mKeySize(0),
   mValueSize(0),
   mIsEmpty(true),
+  mStorageMode(smDouble),
+  mQuantizationRange(0, 1),
   mData(nullptr),
+  mFloatData(nullptr),
+  mQuantizedData(nullptr),
   mAlpha(nullptr),
+  mDataBoundsValid(true),
+  mDataBoundsExact(false),
   mDataModified(true)
 {
   *this = other;
@@ -25891,17 +26284,32 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
     const int valueSize = other.valueSize();
     if (!other.mAlpha && mAlpha)
       clearAlpha();
+    if (other.mStorageMode != mStorageMode || other.mQuantizationRange != mQuantizationRange)
+    {
+      freeData();
+      mKeySize = mValueSize = 0; // makes setSize allocate in the new storage mode
+      mIsEmpty = true;
+      mStorageMode = other.mStorageMode;
+      mQuantizationRange = other.mQuantizationRange;
+    }
     setSize(keySize, valueSize);
     if (other.mAlpha && !mAlpha)
       createAlpha(false);
     setRange(other.keyRange(), other.valueRange());
     if (!isEmpty())
     {
-      memcpy(mData, other.mData, sizeof(mData[0])*size_t(keySize*valueSize));
+      switch (mStorageMode)
+      {
+      case smDouble: memcpy(mData, other.mData, sizeof(mData[0])*size_t(keySize*valueSize)); break;
+      case smFloat: memcpy(mFloatData, other.mFloatData, sizeof(mFloatData[0])*size_t(keySize*valueSize)); break;
+      case smQuantized16: memcpy(mQuantizedData, other.mQuantizedData, sizeof(mQuantizedData[0])*size_t(keySize*valueSize)); break;
+      }
       if (mAlpha)
         memcpy(mAlpha, other.mAlpha, sizeof(mAlpha[0])*size_t(keySize*valueSize));
     }
     mDataBounds = other.mDataBounds;
+    mDataBoundsValid = other.mDataBoundsValid;
+    mDataBoundsExact = other.mDataBoundsExact;
     mDataModified = true;
   }
   return *this;
@@ -25913,16 +26321,16 @@ double QCPColorMapData::data(double key, double value)
   int keyCell = int( (key-mKeyRange.lower)/(mKeyRange.upper-mKeyRange.lower)*(mKeySize-1)+0.5 );
   int valueCell = int( (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5 );
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
-    return mData[valueCell*mKeySize + keyCell];
+    return decodeCell(valueCell*mKeySize + keyCell);
   else
     return 0;
 }
 
 /* undocumented getter */
-double QCPColorMapData::cell(int keyIndex, int valueIndex)
+double QCPColorMapData::cell(int keyIndex, int valueIndex) const
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
-    return mData[valueIndex*mKeySize + keyIndex];
+    return decodeCell(valueIndex*mKeySize + keyIndex);
   else
     return 0;
 }
@@ -25961,23 +26369,15 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
   {
     mKeySize = keySize;
     mValueSize = valueSize;
-    delete[] mData;
+    freeData();
     mIsEmpty = mKeySize == 0 || mValueSize == 0;
     if (!mIsEmpty)
     {
-#ifdef __EXCEPTIONS
-      try { // 2D arrays get memory intensive fast. So if the allocation fails, at least output debug message
-#endif
-      mData = new double[size_t(mKeySize*mValueSize)];
-#ifdef __EXCEPTIONS
-      } catch (...) { mData = nullptr; }
-#endif
-      if (mData)
+      if (allocateData())
         fill(0);
       else
         qDebug() << Q_FUNC_INFO << "out of memory for data dimensions "<< mKeySize << "*" << mValueSize;
-    } else
-      mData = nullptr;
+    }
     
     if (mAlpha) // if we had an alpha map, recreate it with new size
       createAlpha();
@@ -26080,12 +26480,11 @@ void QCPColorMapData::setData(double key, double value, double z)
   int valueCell = int( (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5 );
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
   {
-    mData[valueCell*mKeySize + keyCell] = z;
-    if (z < mDataBounds.lower)
-      mDataBounds.lower = z;
-    if (z > mDataBounds.upper)
-      mDataBounds.upper = z;
-     mDataModified = true;
+    const int index = valueCell*mKeySize + keyCell;
+    const double oldZ = decodeCell(index);
+    encodeCell(index, z);
+    trackDataBounds(oldZ, decodeCell(index));
+    mDataModified = true;
   }
 }
 
@@ -26104,12 +26503,11 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
   {
-    mData[valueIndex*mKeySize + keyIndex] = z;
-    if (z < mDataBounds.lower)
-      mDataBounds.lower = z;
-    if (z > mDataBounds.upper)
-      mDataBounds.upper = z;
-     mDataModified = true;
+    const int index = valueIndex*mKeySize + keyIndex;
+    const double oldZ = decodeCell(index);
+    encodeCell(index, z);
+    trackDataBounds(oldZ, decodeCell(index));
+    mDataModified = true;
   } else
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
 }
@@ -26142,6 +26540,47 @@ void QCPColorMapData::setAlpha(int keyIndex, int valueIndex, unsigned char alpha
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
 }
 
+/*!
+  Sets how the cell values are held in memory. The default, \ref smDouble, stores every value
+  exactly. \ref smFloat halves the memory by rounding values to single precision. \ref
+  smQuantized16 needs a quarter of it: values are clamped to \a quantizationRange and rounded to
+  one of 65535 evenly spaced levels, NaN is preserved. \a quantizationRange is only used by \ref
+  smQuantized16.
+
+  The current cells are converted to the new mode. \ref cell, \ref data, \ref setCell and \ref
+  setData keep working in every mode and return/accept doubles; \ref dataBounds reflect the stored,
+  possibly rounded values. The color map colorizes the compact formats directly, without expanding
+  them to doubles. \ref beginBulkWrite is only available in the \ref smDouble mode.
+*/
+void QCPColorMapData::setStorageMode(StorageMode mode, const QCPRange &quantizationRange)
+{
+  if (mode == mStorageMode && (mode != smQuantized16 || quantizationRange == mQuantizationRange))
+    return;
+  
+  // the current cells move to source, which frees them when done
+  QCPColorMapData source(0, 0, mKeyRange, mValueRange);
+  qSwap(source.mData, mData);
+  qSwap(source.mFloatData, mFloatData);
+  qSwap(source.mQuantizedData, mQuantizedData);
+  source.mStorageMode = mStorageMode;
+  source.mQuantizationRange = mQuantizationRange;
+  mStorageMode = mode;
+  mQuantizationRange = quantizationRange;
+  if (!mIsEmpty)
+  {
+    if (allocateData())
+    {
+      const int dataCount = mKeySize*mValueSize;
+      for (int i=0; i<dataCount; ++i)
+        encodeCell(i, source.decodeCell(i));
+    } else
+      qDebug() << Q_FUNC_INFO << "out of memory for data dimensions "<< mKeySize << "*" << mValueSize;
+  }
+  mDataBoundsValid = false;
+  mDataBoundsExact = false;
+  mDataModified = true;
+}
+
 /*!
   Goes through the data and updates the buffered minimum and maximum data values.
   
@@ -26154,9 +26593,36 @@ void QCPColorMapData::setAlpha(int keyIndex, int valueIndex, unsigned char alpha
   Note that the method \ref QCPColorMap::rescaleDataRange provides a parameter \a
   recalculateDataBounds for convenience. Setting this to true will call this method for you, before
   doing the rescale.
+
+  If the buffered bounds are known to be exact, e.g. after \ref fill or \ref endBulkWrite with
+  bounds, and no extreme cell has been overwritten since, this method returns without touching the
+  data.
 */
 void QCPColorMapData::recalculateDataBounds()
 {
+  if (!mDataBoundsExact || !mDataBoundsValid)
+    updateDataBounds();
+}
+
+/*!
+  Returns the buffered minimum and maximum of the data, see \ref recalculateDataBounds. After a
+  \ref endBulkWrite without bounds, they are computed here on first use.
+*/
+QCPRange QCPColorMapData::dataBounds() const
+{
+  if (!mDataBoundsValid)
+    updateDataBounds();
+  return mDataBounds;
+}
+
+/*! \internal
+
+  Goes through the data and sets the buffered minimum and maximum. NaN cells are ignored.
+*/
+void QCPColorMapData::updateDataBounds() const
+{
+  mDataBoundsValid = true;
+  mDataBoundsExact = true;
   if (mKeySize > 0 && mValueSize > 0)
   {
     double minHeight = std::numeric_limits<double>::max();
@@ -26164,16 +26630,35 @@ void QCPColorMapData::recalculateDataBounds()
     const int dataCount = mValueSize*mKeySize;
     for (int i=0; i<dataCount; ++i)
     {
-      if (mData[i] > maxHeight)
-        maxHeight = mData[i];
-      if (mData[i] < minHeight)
-        minHeight = mData[i];
+      const double z = decodeCell(i);
+      if (z > maxHeight)
+        maxHeight = z;
+      if (z < minHeight)
+        minHeight = z;
     }
     mDataBounds.lower = minHeight;
     mDataBounds.upper = maxHeight;
   }
 }
 
+/*! \internal
+
+  Updates the buffered data bounds for a cell changing from \a oldZ to \a z. The bounds are only
+  extended; if the cell held the minimum or maximum they may now overestimate the data range and
+  are no longer exact. Nothing is tracked while the bounds are unknown anyway.
+*/
+void QCPColorMapData::trackDataBounds(double oldZ, double z)
+{
+  if (!mDataBoundsValid)
+    return;
+  if (mDataBoundsExact && z != oldZ && (oldZ == mDataBounds.lower || oldZ == mDataBounds.upper))
+    mDataBoundsExact = false;
+  if (z < mDataBounds.lower)
+    mDataBounds.lower = z;
+  if (z > mDataBounds.upper)
+    mDataBounds.upper = z;
+}
+
 /*!
   Frees the internal data memory.
   
@@ -26203,8 +26688,20 @@ void QCPColorMapData::clearAlpha()
 void QCPColorMapData::fill(double z)
 {
   const int dataCount = mValueSize*mKeySize;
-  memset(mData, z, dataCount*sizeof(*mData));
+  if (dataCount > 0)
+  {
+    encodeCell(0, z);
+    z = decodeCell(0); // the value as stored, for exact bounds
+  }
+  switch (mStorageMode)
+  {
+  case smDouble: std::fill(mData, mData+dataCount, z); break;
+  case smFloat: std::fill(mFloatData, mFloatData+dataCount, mFloatData ? mFloatData[0] : 0.0f); break;
+  case smQuantized16: std::fill(mQuantizedData, mQuantizedData+dataCount, mQuantizedData ? mQuantizedData[0] : quint16(0)); break;
+  }
   mDataBounds = QCPRange(z, z);
+  mDataBoundsValid = true;
+  mDataBoundsExact = true;
   mDataModified = true;
 }
 
@@ -26227,6 +26724,52 @@ void QCPColorMapData::fillAlpha(unsigned char alpha)
   }
 }
 
+/*!
+  Returns a pointer to the internal data array for writing many cells at once, or \c nullptr if
+  this instance is empty (see \ref isEmpty) or doesn't use the \ref smDouble storage mode.
+
+  The array is row-major with \ref keySize cells per row: the cell (\a keyIndex, \a valueIndex)
+  is at <tt>valueIndex*keySize() + keyIndex</tt>. Unlike \ref setCell, writing through the pointer
+  performs no bounds checks and doesn't update the buffered data bounds, so different rows may be
+  filled concurrently from several threads. Call \ref endBulkWrite once all writes are done,
+  preferably passing the bounds of the written values, which each thread can track for its own
+  cells and the caller merges.
+
+  \see endBulkWrite, setCell
+*/
+double *QCPColorMapData::beginBulkWrite()
+{
+  return mIsEmpty ? nullptr : mData;
+}
+
+/*!
+  Finishes a write started with \ref beginBulkWrite: marks the data as modified, so the color map
+  image is rebuilt on the next replot. The data bounds become unknown and are recalculated in a
+  single pass when they are needed next, e.g. by \ref dataBounds.
+
+  \see beginBulkWrite, recalculateDataBounds
+*/
+void QCPColorMapData::endBulkWrite()
+{
+  mDataBoundsValid = false;
+  mDataBoundsExact = false;
+  mDataModified = true;
+}
+
+/*! \overload
+
+  Finishes a write started with \ref beginBulkWrite like \ref endBulkWrite(), taking \a bounds as
+  the exact minimum and maximum of the whole data, so neither \ref dataBounds nor \ref
+  recalculateDataBounds need another pass over the cells.
+*/
+void QCPColorMapData::endBulkWrite(const QCPRange &bounds)
+{
+  mDataBounds = bounds;
+  mDataBoundsValid = true;
+  mDataBoundsExact = true;
+  mDataModified = true;
+}
+
 /*!
   Transforms plot coordinates given by \a key and \a value to cell indices of this QCPColorMapData
   instance. The resulting cell indices are returned via the output parameters \a keyIndex and \a
@@ -26275,6 +26818,109 @@ void QCPColorMapData::cellToCoord(int keyIndex, int valueIndex, double *key, dou
     *value = valueIndex/double(mValueSize-1)*(mValueRange.upper-mValueRange.lower)+mValueRange.lower;
 }
 
+/*! \internal
+
+  Allocates the cell array of the current storage mode for \ref keySize times \ref valueSize cells,
+  without initializing it. Returns false if the allocation failed.
+*/
+bool QCPColorMapData::allocateData()
+{
+  const size_t dataCount = size_t(mKeySize*mValueSize);
+#ifdef __EXCEPTIONS
+  try { // 2D arrays get memory intensive fast. So if the allocation fails, at least output debug message
+#endif
+  switch (mStorageMode)
+  {
+  case smDouble: mData = new double[dataCount]; return true;
+  case smFloat: mFloatData = new float[dataCount]; return true;
+  case smQuantized16: mQuantizedData = new quint16[dataCount]; return true;
+  }
+#ifdef __EXCEPTIONS
+  } catch (...) { }
+#endif
+  return false;
+}
+
+/*! \internal
+
+  Frees the cell array, whichever storage mode it was allocated for.
+*/
+void QCPColorMapData::freeData()
+{
+  delete[] mData;
+  delete[] mFloatData;
+  delete[] mQuantizedData;
+  mData = nullptr;
+  mFloatData = nullptr;
+  mQuantizedData = nullptr;
+}
+
+/*! \internal
+
+  Returns the value of the cell at the linear \a index (<tt>valueIndex*keySize + keyIndex</tt>),
+  converted from the current storage mode.
+*/
+double QCPColorMapData::decodeCell(int index) const
+{
+  switch (mStorageMode)
+  {
+  case smDouble: return mData[index];
+  case smFloat: return mFloatData[index];
+  case smQuantized16: return qcpDequantize(mQuantizedData[index], mQuantizationRange.lower, mQuantizationRange.size()/65534.0);
+  }
+  return 0;
+}
+
+/*! \internal
+
+  Stores \a z in the cell at the linear \a index, converted to the current storage mode.
+*/
+void QCPColorMapData::encodeCell(int index, double z)
+{
+  switch (mStorageMode)
+  {
+  case smDouble: mData[index] = z; break;
+  case smFloat: mFloatData[index] = float(z); break;
+  case smQuantized16:
+  {
+    const double step = mQuantizationRange.size()/65534.0;
+    if (std::isnan(z))
+      mQuantizedData[index] = 65535;
+    else if (!(step > 0))
+      mQuantizedData[index] = 0;
+    else
+      mQuantizedData[index] = quint16(qRound(qBound(0.0, (z-mQuantizationRange.lower)/step, 65534.0))); // clamped first, so infinities are safe
+    break;
+  }
+  }
+}
+
+/*! \internal
+
+  Colorizes \a n cells starting at the linear index \a offset, \a dataIndexFactor apart, into \a
+  scanLine with \a gradient, reading the cells in their storage format. Used by \ref
+  QCPColorMap::updateMapImage.
+*/
+void QCPColorMapData::colorizeCells(QCPColorGradient *gradient, int offset, int dataIndexFactor, int n, const QCPRange &range, bool logarithmic, QRgb *scanLine) const
+{
+  const unsigned char *alpha = mAlpha ? mAlpha+offset : nullptr;
+  switch (mStorageMode)
+  {
+  case smDouble:
+    if (alpha)
+      gradient->colorize(mData+offset, alpha, range, scanLine, n, dataIndexFactor, logarithmic);
+    else
+      gradient->colorize(mData+offset, range, scanLine, n, dataIndexFactor, logarithmic);
+    break;
+  case smFloat:
+    gradient->colorize(mFloatData+offset, alpha, range, scanLine, n, dataIndexFactor, logarithmic);
+    break;
+  case smQuantized16:
+    gradient->colorize(mQuantizedData+offset, mQuantizationRange, alpha, range, scanLine, n, dataIndexFactor, logarithmic);
+    break;
+  }
+}
+
 /*! \internal
 
   Allocates the internal alpha map with the current data map key/value size and, if \a
@@ -26445,12 +27091,17 @@ QCPColorMap::QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mGradient(QCPColorGradient::gpCold),
   mInterpolate(true),
   mTightBoundary(false),
-  mMapImageInvalidated(true)
+  mMipmapping(false),
+  mMipReduction(mrMean),
+  mMapImageInvalidated(true),
+  mMipLevelsInvalidated(true),
+  mMapImageLevel(0)
 {
 }
 
 QCPColorMap::~QCPColorMap()
 {
+  qDeleteAll(mMipLevels);
   delete mMapData;
 }
 
@@ -26477,6 +27128,7 @@ void QCPColorMap::setData(QCPColorMapData *data, bool copy)
     mMapData = data;
   }
   mMapImageInvalidated = true;
+  mMipLevelsInvalidated = true;
 }
 
 /*!
@@ -26567,6 +27219,45 @@ void QCPColorMap::setTightBoundary(bool enabled)
   mTightBoundary = enabled;
 }
 
+/*!
+  Sets whether the color map keeps a mip pyramid of its data: a chain of levels, each halving the
+  cell counts of the previous one by combining 2x2 cells as defined by \ref setMipReduction.
+
+  When the map is drawn with more cells than there are pixels, the map image is colorized from the
+  level whose cell count is closest to, but not below, the on-screen pixel count. The cost of
+  colorizing and drawing the map then depends on the size of the map on screen rather than on the
+  number of cells. The pyramid is built on the first draw after the data has changed, and takes a
+  third of the memory of the data in double precision. Mipmapping is disabled by default.
+
+  \see setMipReduction
+*/
+void QCPColorMap::setMipmapping(bool enabled)
+{
+  if (mMipmapping != enabled)
+  {
+    mMipmapping = enabled;
+    mMipLevelsInvalidated = true;
+    mMapImageInvalidated = true;
+  }
+}
+
+/*!
+  Sets how the cells of coarser mip levels are computed, see \ref MipReduction. For example \ref
+  mrMinimum keeps narrow valleys of a surface visible when zoomed out, while the default \ref
+  mrMean shows the average.
+
+  \see setMipmapping
+*/
+void QCPColorMap::setMipReduction(MipReduction reduction)
+{
+  if (mMipReduction != reduction)
+  {
+    mMipReduction = reduction;
+    mMipLevelsInvalidated = true;
+    mMapImageInvalidated = true;
+  }
+}
+
 /*!
   Associates the color scale \a colorScale with this color map.
   
@@ -26737,6 +27428,35 @@ QCPRange QCPColorMap::getValueRange(bool &foundRange, QCP::SignDomain inSignDoma
   return result;
 }
 
+/*! \internal
+
+  Colorizes the scanlines [\a begin, \a end) of a color map image by calling \a colorizeLines and
+  releases \a done afterwards. Used by \ref QCPColorMap::updateMapImage to distribute large maps
+  over the threads of QThreadPool::globalInstance().
+*/
+class QCPColorMapLinesTask : public QRunnable
+{
+public:
+  QCPColorMapLinesTask(const std::function<void(int, int)> &colorizeLines, int begin, int end, QSemaphore *done) :
+    mColorizeLines(colorizeLines),
+    mBegin(begin),
+    mEnd(end),
+    mDone(done)
+  {
+  }
+  
+  virtual void run() Q_DECL_OVERRIDE
+  {
+    mColorizeLines(mBegin, mEnd);
+    mDone->release();
+  }
+  
+private:
+  std::function<void(int, int)> mColorizeLines;
+  int mBegin, mEnd;
+  QSemaphore *mDone;
+};
+
 /*! \internal
   
   Updates the internal map image buffer by going through the internal \ref QCPColorMapData and
@@ -26756,10 +27476,15 @@ void QCPColorMap::updateMapImage()
   QCPAxis *keyAxis = mKeyAxis.data();
   if (!keyAxis) return;
   if (mMapData->isEmpty()) return;
+  // data modifications invalidate the mip levels in draw(), which also rebuilds them when selecting
+  // the level; mMapImageLevel is only nonzero after such a draw
+  if (mMipLevelsInvalidated && mMapImageLevel > 0)
+    updateMipLevels();
+  const QCPColorMapData *source = mapImageSource();
   
   const QImage::Format format = QImage::Format_ARGB32_Premultiplied;
-  const int keySize = mMapData->keySize();
-  const int valueSize = mMapData->valueSize();
+  const int keySize = source->keySize();
+  const int valueSize = source->valueSize();
   int keyOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(keySize)); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
   int valueOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(valueSize)); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
   
@@ -26788,32 +27513,67 @@ void QCPColorMap::updateMapImage()
     } else if (!mUndersampledMapImage.isNull())
       mUndersampledMapImage = QImage(); // don't need oversampling mechanism anymore (map size has changed) but mUndersampledMapImage still has nonzero size, free it
     
-    const double *rawData = mMapData->mData;
-    const unsigned char *rawAlpha = mMapData->mAlpha;
+    const QCPColorMapData *mapData = source;
+    const bool logarithmic = mDataScaleType==QCPAxis::stLogarithmic;
+    QCPColorGradient *gradient = &mGradient;
+    const QCPRange dataRange = mDataRange;
+    // scanLine() detaches the image on every call, so lines are addressed from bits() instead, which detaches only once
+    uchar *imageBits = localMapImage->bits();
+    const qint64 bytesPerLine = localMapImage->bytesPerLine();
+    const int lineCount = keyAxis->orientation() == Qt::Horizontal ? valueSize : keySize;
+    std::function<void(int, int)> colorizeLines;
     if (keyAxis->orientation() == Qt::Horizontal)
     {
-      const int lineCount = valueSize;
       const int rowCount = keySize;
-      for (int line=0; line<lineCount; ++line)
+      colorizeLines = [=](int begin, int end)
       {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-        if (rawAlpha)
-          mGradient.colorize(rawData+line*rowCount, rawAlpha+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-        else
-          mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-      }
+        for (int line=begin; line<end; ++line)
+        {
+          QRgb* pixels = reinterpret_cast<QRgb*>(imageBits+(lineCount-1-line)*bytesPerLine); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+          mapData->colorizeCells(gradient, line*rowCount, 1, rowCount, dataRange, logarithmic, pixels);
+        }
+      };
     } else // keyAxis->orientation() == Qt::Vertical
     {
-      const int lineCount = keySize;
       const int rowCount = valueSize;
-      for (int line=0; line<lineCount; ++line)
+      colorizeLines = [=](int begin, int end)
       {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-        if (rawAlpha)
-          mGradient.colorize(rawData+line, rawAlpha+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+        for (int line=begin; line<end; ++line)
+        {
+          QRgb* pixels = reinterpret_cast<QRgb*>(imageBits+(lineCount-1-line)*bytesPerLine); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+          mapData->colorizeCells(gradient, line, lineCount, rowCount, dataRange, logarithmic, pixels);
+        }
+      };
+    }
+    
+    // the first line is always colorized here: it brings the gradient's color buffer up to date, after
+    // which concurrent colorize calls only read it
+    colorizeLines(0, qMin(1, lineCount));
+    const int taskCount = qint64(keySize)*qint64(valueSize) < 512*512 ? 1 : qBound(1, QThreadPool::globalInstance()->maxThreadCount(), (lineCount-1)/16);
+    if (taskCount <= 1)
+    {
+      colorizeLines(1, lineCount);
+    } else
+    {
+      // scanlines are split into consecutive bands, the first band runs in this thread. A band whose task can't
+      // start immediately runs here as well, so a busy pool never makes us wait for it
+      QSemaphore done;
+      const int bandSize = (lineCount-1+taskCount-1)/taskCount;
+      int started = 0;
+      for (int begin=1+bandSize; begin<lineCount; begin+=bandSize)
+      {
+        QCPColorMapLinesTask *task = new QCPColorMapLinesTask(colorizeLines, begin, qMin(begin+bandSize, lineCount), &done);
+        if (QThreadPool::globalInstance()->tryStart(task))
+          ++started;
         else
-          mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+        {
+          task->run();
+          done.acquire();
+          delete task;
+        }
       }
+      colorizeLines(1, qMin(1+bandSize, lineCount));
+      done.acquire(started);
     }
     
     if (keyOversamplingFactor > 1 || valueOversamplingFactor > 1)
@@ -26835,8 +27595,26 @@ void QCPColorMap::draw(QCPPainter *painter)
   if (!mKeyAxis || !mValueAxis) return;
   applyDefaultAntialiasingHint(painter);
   
+  if (mMipmapping)
+  {
+    if (mMapData->mDataModified)
+      mMipLevelsInvalidated = true;
+    const QSizeF mapPixelSize = QRectF(coordsToPixels(mMapData->keyRange().lower, mMapData->valueRange().lower),
+                                       coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized().size();
+    const int level = selectMipLevel(mapPixelSize);
+    if (level != mMapImageLevel)
+    {
+      mMapImageLevel = level;
+      mMapImageInvalidated = true;
+    }
+  } else if (mMapImageLevel != 0)
+  {
+    mMapImageLevel = 0;
+    mMapImageInvalidated = true;
+  }
   if (mMapData->mDataModified || mMapImageInvalidated)
     updateMapImage();
+  const QCPColorMapData *source = mapImageSource();
   
   // use buffer if painting vectorized (PDF):
   const bool useBuffer = painter->modes().testFlag(QCPPainter::pmVectorized);
@@ -26854,23 +27632,23 @@ void QCPColorMap::draw(QCPPainter *painter)
     localPainter->translate(-mapBufferTarget.topLeft());
   }
   
-  QRectF imageRect = QRectF(coordsToPixels(mMapData->keyRange().lower, mMapData->valueRange().lower),
-                            coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized();
+  QRectF imageRect = QRectF(coordsToPixels(source->keyRange().lower, source->valueRange().lower),
+                            coordsToPixels(source->keyRange().upper, source->valueRange().upper)).normalized();
   // extend imageRect to contain outer halves/quarters of bordering/cornering pixels (cells are centered on map range boundary):
   double halfCellWidth = 0; // in pixels
   double halfCellHeight = 0; // in pixels
   if (keyAxis()->orientation() == Qt::Horizontal)
   {
-    if (mMapData->keySize() > 1)
-      halfCellWidth = 0.5*imageRect.width()/double(mMapData->keySize()-1);
-    if (mMapData->valueSize() > 1)
-      halfCellHeight = 0.5*imageRect.height()/double(mMapData->valueSize()-1);
+    if (source->keySize() > 1)
+      halfCellWidth = 0.5*imageRect.width()/double(source->keySize()-1);
+    if (source->valueSize() > 1)
+      halfCellHeight = 0.5*imageRect.height()/double(source->valueSize()-1);
   } else // keyAxis orientation is Qt::Vertical
   {
-    if (mMapData->keySize() > 1)
-      halfCellHeight = 0.5*imageRect.height()/double(mMapData->keySize()-1);
-    if (mMapData->valueSize() > 1)
-      halfCellWidth = 0.5*imageRect.width()/double(mMapData->valueSize()-1);
+    if (source->keySize() > 1)
+      halfCellHeight = 0.5*imageRect.height()/double(source->keySize()-1);
+    if (source->valueSize() > 1)
+      halfCellWidth = 0.5*imageRect.width()/double(source->valueSize()-1);
   }
   imageRect.adjust(-halfCellWidth, -halfCellHeight, halfCellWidth, halfCellHeight);
   const bool mirrorX = (keyAxis()->orientation() == Qt::Horizontal ? keyAxis() : valueAxis())->rangeReversed();
@@ -26897,6 +27675,138 @@ void QCPColorMap::draw(QCPPainter *painter)
   }
 }
 
+/*! \internal
+
+  Rebuilds the mip pyramid of the current data, see \ref setMipmapping. Levels are created until
+  neither dimension exceeds 64 cells.
+*/
+void QCPColorMap::updateMipLevels()
+{
+  qDeleteAll(mMipLevels);
+  mMipLevels.clear();
+  mMipLevelsInvalidated = false;
+  if (!mMipmapping)
+    return;
+  const QCPColorMapData *source = mMapData;
+  while (!source->isEmpty() && qMax(source->keySize(), source->valueSize()) > 64)
+  {
+    mMipLevels.append(createMipLevel(source));
+    source = mMipLevels.last();
+  }
+}
+
+/*! \internal
+
+  Returns a new color map data with half the cells of \a source in each dimension (rounded up, a
+  dimension of size one is kept), combining up to 2x2 cells according to \ref mipReduction. Each
+  new cell lies midway between the cells it combines, the levels being evenly spaced. For an odd
+  source size, the last new cell holds only the last source cell, as if it were repeated once past
+  the border, and so lies half a source cell beyond it: values near that border shift outwards by
+  up to half a source cell, and the map extends past its data range by as much, which \ref
+  setTightBoundary clips. A cell alpha map is reduced to the mean alpha.
+*/
+QCPColorMapData *QCPColorMap::createMipLevel(const QCPColorMapData *source) const
+{
+  const int sourceKeySize = source->keySize();
+  const int sourceValueSize = source->valueSize();
+  const int keySize = (sourceKeySize+1)/2;
+  const int valueSize = (sourceValueSize+1)/2;
+  QCPRange keyRange = source->keyRange();
+  QCPRange valueRange = source->valueRange();
+  if (sourceKeySize > 1)
+  {
+    const double keyStep = keyRange.size()/double(sourceKeySize-1);
+    keyRange.lower += 0.5*keyStep;
+    keyRange.upper = keyRange.lower + (keySize-1)*2*keyStep;
+  }
+  if (sourceValueSize > 1)
+  {
+    const double valueStep = valueRange.size()/double(sourceValueSize-1);
+    valueRange.lower += 0.5*valueStep;
+    valueRange.upper = valueRange.lower + (valueSize-1)*2*valueStep;
+  }
+  
+  QCPColorMapData *result = new QCPColorMapData(keySize, valueSize, keyRange, valueRange);
+  double *cells = result->beginBulkWrite();
+  unsigned char *alpha = source->mAlpha && result->createAlpha(false) ? result->mAlpha : nullptr;
+  if (!cells)
+    return result;
+  for (int valueIndex=0; valueIndex<valueSize; ++valueIndex)
+  {
+    for (int keyIndex=0; keyIndex<keySize; ++keyIndex)
+    {
+      double sum = 0, low = 0, high = 0;
+      int count = 0, alphaSum = 0, alphaCount = 0;
+      for (int sourceValue=2*valueIndex; sourceValue<qMin(2*valueIndex+2, sourceValueSize); ++sourceValue)
+      {
+        for (int sourceKey=2*keyIndex; sourceKey<qMin(2*keyIndex+2, sourceKeySize); ++sourceKey)
+        {
+          const int index = sourceValue*sourceKeySize + sourceKey;
+          if (alpha)
+          {
+            alphaSum += source->mAlpha[index];
+            ++alphaCount;
+          }
+          const double z = source->decodeCell(index);
+          if (qIsNaN(z))
+            continue;
+          sum += z;
+          low = count == 0 ? z : qMin(low, z);
+          high = count == 0 ? z : qMax(high, z);
+          ++count;
+        }
+      }
+      double z = qQNaN();
+      if (count > 0)
+      {
+        switch (mMipReduction)
+        {
+        case mrMean: z = sum/count; break;
+        case mrMinimum: z = low; break;
+        case mrMaximum: z = high; break;
+        }
+      }
+      cells[valueIndex*keySize + keyIndex] = z;
+      if (alpha)
+        alpha[valueIndex*keySize + keyIndex] = static_cast<unsigned char>(alphaSum/alphaCount);
+    }
+  }
+  result->endBulkWrite();
+  return result;
+}
+
+/*! \internal
+
+  Returns the mip level to colorize the map from, when the whole map spans \a mapPixelSize on
+  screen: the coarsest level that still has at least one cell per pixel in both dimensions. Builds
+  the mip pyramid first, if necessary.
+*/
+int QCPColorMap::selectMipLevel(const QSizeF &mapPixelSize)
+{
+  if (mMipLevelsInvalidated)
+    updateMipLevels();
+  const bool keyHorizontal = keyAxis()->orientation() == Qt::Horizontal;
+  const double keyPixels = qMax(1.0, keyHorizontal ? mapPixelSize.width() : mapPixelSize.height());
+  const double valuePixels = qMax(1.0, keyHorizontal ? mapPixelSize.height() : mapPixelSize.width());
+  // cells per pixel along the sparser dimension; level l has about 1/2^l of the cells per dimension
+  const double density = qMin(mMapData->keySize()/keyPixels, mMapData->valueSize()/valuePixels);
+  int level = 0;
+  while (level < mMipLevels.size() && density >= double(2 << level))
+    ++level;
+  return level;
+}
+
+/*! \internal
+
+  Returns the data mMapImage is built from: the mip level \a mMapImageLevel, or \ref data itself.
+*/
+const QCPColorMapData *QCPColorMap::mapImageSource() const
+{
+  if (mMapImageLevel > 0 && mMapImageLevel <= mMipLevels.size())
+    return mMipLevels.at(mMapImageLevel-1);
+  return mMapData;
+}
+
 /* inherits documentation from base class */
 void QCPColorMap::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
 {
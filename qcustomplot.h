@@ -4820,6 +4820,8 @@ public:
   // non-property methods:
   void colorize(const double *data, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
   void colorize(const double *data, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
+  void colorize(const float *data, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
+  void colorize(const quint16 *data, const QCPRange &quantizationRange, const unsigned char *alpha, const QCPRange &range, QRgb *scanLine, int n, int dataIndexFactor=1, bool logarithmic=false);
   QRgb color(double position, const QCPRange &range, bool logarithmic=false);
   void loadPreset(GradientPreset preset);
   void clearColorStops();
@@ -4841,6 +4843,7 @@ protected:
   // non-virtual methods:
   bool stopsUseAlpha() const;
   void updateColorBuffer();
+  QRgb nanColorRgb() const;
 };
 Q_DECLARE_METATYPE(QCPColorGradient::ColorInterpolation)
 Q_DECLARE_METATYPE(QCPColorGradient::NanHandling)
@@ -5638,6 +5641,7 @@ class QCP_LIB_DECL QCPCurve : public QCPAbstractPlottable1D<QCPCurveData>
   Q_PROPERTY(QCPScatterStyle scatterStyle READ scatterStyle WRITE setScatterStyle)
   Q_PROPERTY(int scatterSkip READ scatterSkip WRITE setScatterSkip)
   Q_PROPERTY(LineStyle lineStyle READ lineStyle WRITE setLineStyle)
+  Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
   /// \endcond
 public:
   /*!
@@ -5658,6 +5662,7 @@ public:
   QCPScatterStyle scatterStyle() const { return mScatterStyle; }
   int scatterSkip() const { return mScatterSkip; }
   LineStyle lineStyle() const { return mLineStyle; }
+  bool adaptiveSampling() const { return mAdaptiveSampling; }
   
   // setters:
   void setData(QSharedPointer<QCPCurveDataContainer> data);
@@ -5666,6 +5671,7 @@ public:
   void setScatterStyle(const QCPScatterStyle &style);
   void setScatterSkip(int skip);
   void setLineStyle(LineStyle style);
+  void setAdaptiveSampling(bool enabled);
   
   // non-property methods:
   void addData(const QVector<double> &t, const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
@@ -5683,6 +5689,7 @@ protected:
   QCPScatterStyle mScatterStyle;
   int mScatterSkip;
   LineStyle mLineStyle;
+  bool mAdaptiveSampling;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -6022,6 +6029,14 @@ protected:
 class QCP_LIB_DECL QCPColorMapData
 {
 public:
+  /*!
+    Defines how the cell values are held in memory, see \ref setStorageMode.
+  */
+  enum StorageMode { smDouble      ///< 8 bytes per cell, values are stored exactly (default)
+                     ,smFloat      ///< 4 bytes per cell, values are rounded to single precision
+                     ,smQuantized16 ///< 2 bytes per cell, values are quantized to 65535 levels of the quantization range, NaN is kept
+                   };
+  
   QCPColorMapData(int keySize, int valueSize, const QCPRange &keyRange, const QCPRange &valueRange);
   ~QCPColorMapData();
   QCPColorMapData(const QCPColorMapData &other);
@@ -6032,9 +6047,11 @@ public:
   int valueSize() const { return mValueSize; }
   QCPRange keyRange() const { return mKeyRange; }
   QCPRange valueRange() const { return mValueRange; }
-  QCPRange dataBounds() const { return mDataBounds; }
+  QCPRange dataBounds() const;
+  StorageMode storageMode() const { return mStorageMode; }
+  QCPRange quantizationRange() const { return mQuantizationRange; }
   double data(double key, double value);
-  double cell(int keyIndex, int valueIndex);
+  double cell(int keyIndex, int valueIndex) const;
   unsigned char alpha(int keyIndex, int valueIndex);
   
   // setters:
@@ -6047,6 +6064,7 @@ public:
   void setData(double key, double value, double z);
   void setCell(int keyIndex, int valueIndex, double z);
   void setAlpha(int keyIndex, int valueIndex, unsigned char alpha);
+  void setStorageMode(StorageMode mode, const QCPRange &quantizationRange=QCPRange(0, 1));
   
   // non-property methods:
   void recalculateDataBounds();
@@ -6054,6 +6072,9 @@ public:
   void clearAlpha();
   void fill(double z);
   void fillAlpha(unsigned char alpha);
+  double *beginBulkWrite();
+  void endBulkWrite();
+  void endBulkWrite(const QCPRange &bounds);
   bool isEmpty() const { return mIsEmpty; }
   void coordToCell(double key, double value, int *keyIndex, int *valueIndex) const;
   void cellToCoord(int keyIndex, int valueIndex, double *key, double *value) const;
@@ -6063,14 +6084,27 @@ protected:
   int mKeySize, mValueSize;
   QCPRange mKeyRange, mValueRange;
   bool mIsEmpty;
+  StorageMode mStorageMode;
+  QCPRange mQuantizationRange;
   
   // non-property members:
-  double *mData;
+  double *mData; // only one of mData, mFloatData and mQuantizedData is allocated, according to mStorageMode
+  float *mFloatData;
+  quint16 *mQuantizedData;
   unsigned char *mAlpha;
-  QCPRange mDataBounds;
+  mutable QCPRange mDataBounds;
+  mutable bool mDataBoundsValid; // false after a bulk write without bounds, computed on demand
+  mutable bool mDataBoundsExact; // mDataBounds are the true minimum and maximum, not just enclosing them
   bool mDataModified;
   
   bool createAlpha(bool initializeOpaque=true);
+  bool allocateData();
+  void freeData();
+  double decodeCell(int index) const;
+  void encodeCell(int index, double z);
+  void colorizeCells(QCPColorGradient *gradient, int offset, int dataIndexFactor, int n, const QCPRange &range, bool logarithmic, QRgb *scanLine) const;
+  void updateDataBounds() const;
+  void trackDataBounds(double oldZ, double z);
   
   friend class QCPColorMap;
 };
@@ -6086,8 +6120,22 @@ class QCP_LIB_DECL QCPColorMap : public QCPAbstractPlottable
   Q_PROPERTY(bool interpolate READ interpolate WRITE setInterpolate)
   Q_PROPERTY(bool tightBoundary READ tightBoundary WRITE setTightBoundary)
   Q_PROPERTY(QCPColorScale* colorScale READ colorScale WRITE setColorScale)
+  Q_PROPERTY(bool mipmapping READ mipmapping WRITE setMipmapping)
+  Q_PROPERTY(MipReduction mipReduction READ mipReduction WRITE setMipReduction)
   /// \endcond
 public:
+  /*!
+    Defines how the cells of a coarser mip level are computed from the up to 2x2 cells they cover.
+    NaN cells are ignored, a cell covering only NaN cells is NaN.
+    
+    \see setMipmapping, setMipReduction
+  */
+  enum MipReduction { mrMean    ///< the mean of the covered cells
+                      ,mrMinimum ///< the smallest covered cell
+                      ,mrMaximum ///< the largest covered cell
+                    };
+  Q_ENUMS(MipReduction)
+  
   explicit QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
   virtual ~QCPColorMap() Q_DECL_OVERRIDE;
   
@@ -6099,6 +6147,8 @@ public:
   bool tightBoundary() const { return mTightBoundary; }
   QCPColorGradient gradient() const { return mGradient; }
   QCPColorScale *colorScale() const { return mColorScale.data(); }
+  bool mipmapping() const { return mMipmapping; }
+  MipReduction mipReduction() const { return mMipReduction; }
   
   // setters:
   void setData(QCPColorMapData *data, bool copy=false);
@@ -6108,6 +6158,8 @@ public:
   void setInterpolate(bool enabled);
   void setTightBoundary(bool enabled);
   void setColorScale(QCPColorScale *colorScale);
+  void setMipmapping(bool enabled);
+  void setMipReduction(MipReduction reduction);
   
   // non-property methods:
   void rescaleDataRange(bool recalculateDataBounds=false);
@@ -6132,11 +6184,16 @@ protected:
   bool mInterpolate;
   bool mTightBoundary;
   QPointer<QCPColorScale> mColorScale;
+  bool mMipmapping;
+  MipReduction mMipReduction;
   
   // non-property members:
   QImage mMapImage, mUndersampledMapImage;
   QPixmap mLegendIcon;
   bool mMapImageInvalidated;
+  QList<QCPColorMapData*> mMipLevels; // level i+1 halves the cell counts of level i, level 0 is mMapData
+  bool mMipLevelsInvalidated;
+  int mMapImageLevel; // mip level mMapImage is built from
   
   // introduced virtual methods:
   virtual void updateMapImage();
@@ -6145,9 +6202,16 @@ protected:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
   
+  // non-virtual methods:
+  void updateMipLevels();
+  QCPColorMapData *createMipLevel(const QCPColorMapData *source) const;
+  int selectMipLevel(const QSizeF &mapPixelSize);
+  const QCPColorMapData *mapImageSource() const;
+  
   friend class QCustomPlot;
   friend class QCPLegend;
 };
+Q_DECLARE_METATYPE(QCPColorMap::MipReduction)
 
 /* end of 'src/plottables/plottable-colormap.h' */
 
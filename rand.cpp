@@ -1,4 +1,6 @@
 #include "rand.h"
+#include <atomic>
+#include <cmath>
 #include <random>
 
 template<typename T>
@@ -11,18 +13,198 @@ static constexpr T power(T a, size_t n) {
     return n == 0 ? 1 : sqr(power(a, n / 2)) * (n % 2 == 0 ?  1 : a);
 }
 
+static constexpr uint64_t rotl(uint64_t const x, int const k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static constexpr uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+rng::rng(uint64_t seed) noexcept
+{
+    this->seed(seed);
+}
+
+void rng::seed(uint64_t seed) noexcept
+{
+    for (auto& elem : s) {
+        elem = splitmix64(seed);
+    }
+}
+
+uint64_t rng::operator()() noexcept
+{
+    uint64_t const result = rotl(s[1] * 5, 7) * 9;
+    uint64_t const t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+uint32_t rng::bounded(uint32_t range) noexcept
+{
+    if (range == 0) {
+        return static_cast<uint32_t>((*this)() >> 32);
+    }
+    uint64_t m = ((*this)() >> 32) * range;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < range) {
+        uint32_t const threshold = -range % range;
+        while (low < threshold) {
+            m = ((*this)() >> 32) * range;
+            low = static_cast<uint32_t>(m);
+        }
+    }
+    return static_cast<uint32_t>(m >> 32);
+}
+
+uint64_t rng::bounded64(uint64_t range) noexcept
+{
+    if (range == 0) {
+        return (*this)();
+    }
+    uint64_t const threshold = -range % range;
+    uint64_t x;
+    do {
+        x = (*this)();
+    } while (x < threshold);
+    return x % range;
+}
+
+double rng::uniform() noexcept
+{
+    return ((*this)() >> 11) * 0x1.0p-53;
+}
+
+void rng::jump() noexcept
+{
+    static constexpr uint64_t poly[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+    uint64_t t[4] = {0, 0, 0, 0};
+
+    for (auto const& word : poly) {
+        for (int bit = 0; bit < 64; ++bit) {
+            if (word & (uint64_t{1} << bit)) {
+                for (int i = 0; i < 4; ++i) {
+                    t[i] ^= s[i];
+                }
+            }
+            (*this)();
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        s[i] = t[i];
+    }
+}
+
+static constexpr void mulhilo(uint32_t const a, uint32_t const b, uint32_t& hi, uint32_t& lo) {
+    uint64_t const product = static_cast<uint64_t>(a) * b;
+    hi = static_cast<uint32_t>(product >> 32);
+    lo = static_cast<uint32_t>(product);
+}
+
+std::array<uint32_t, 4> philox(uint64_t seed, uint32_t step, uint64_t lane, uint32_t block) noexcept
+{
+    uint32_t c[4] = {static_cast<uint32_t>(lane), static_cast<uint32_t>(lane >> 32), step, block};
+    uint32_t k[2] = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    uint32_t hi0, lo0, hi1, lo1;
+
+    for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+            k[0] += 0x9E3779B9;
+            k[1] += 0xBB67AE85;
+        }
+        mulhilo(0xD2511F53, c[0], hi0, lo0);
+        mulhilo(0xCD9E8D57, c[2], hi1, lo1);
+        c[0] = hi1 ^ c[1] ^ k[0];
+        c[1] = lo1;
+        c[2] = hi0 ^ c[3] ^ k[1];
+        c[3] = lo0;
+    }
+    return {c[0], c[1], c[2], c[3]};
+}
+
+uint32_t philox_bounded(uint64_t seed, uint32_t step, uint64_t lane, uint32_t range) noexcept
+{
+    uint32_t const threshold = -range % range;
+    for (uint32_t block = 0;; ++block) {
+        for (auto const& word : philox(seed, step, lane, block)) {
+            uint64_t const m = static_cast<uint64_t>(word) * range;
+            if (static_cast<uint32_t>(m) >= threshold) {
+                return static_cast<uint32_t>(m >> 32);
+            }
+        }
+    }
+}
+
+uint64_t philox_bounded64(uint64_t seed, uint32_t step, uint64_t lane, uint64_t range) noexcept
+{
+    uint64_t const threshold = -range % range;
+    for (uint32_t block = 0;; ++block) {
+        auto const w = philox(seed, step, lane, block);
+        for (uint64_t const x : {uint64_t{w[0]} << 32 | w[1], uint64_t{w[2]} << 32 | w[3]}) {
+            if (x >= threshold) {
+                return x % range;
+            }
+        }
+    }
+}
+
+static std::atomic<uint64_t> global_seed{std::random_device{}()};
+static std::atomic<uint64_t> seed_generation{0};
+static std::atomic<uint64_t> thread_count{0};
+
+rng& thread_rng()
+{
+    thread_local uint64_t const index = thread_count++;
+    thread_local uint64_t generation = UINT64_MAX;
+    thread_local rng gen;
+
+    uint64_t const current = seed_generation.load(std::memory_order_acquire);
+    if (generation != current) {
+        generation = current;
+        gen.seed(global_seed.load(std::memory_order_relaxed));
+        for (uint64_t i = 0; i < index; ++i) {
+            gen.jump();
+        }
+    }
+    return gen;
+}
+
+void set_seed(uint64_t seed)
+{
+    global_seed.store(seed, std::memory_order_relaxed);
+    seed_generation.fetch_add(1, std::memory_order_release);
+}
+
 int random(int begin, int end)
 {
-    static std::mt19937 gen { std::random_device{}() };
-//    static std::mt19937 gen{0};
-    static std::uniform_int_distribution<int> dist(0, std::numeric_limits<int>::max());
-    return (dist(gen) % (end - begin + 1)) + begin;
+    int64_t const range = static_cast<int64_t>(end) - begin + 1;
+    return static_cast<int>(begin + static_cast<int64_t>(thread_rng().bounded(static_cast<uint32_t>(range))));
 }
 
 double random(double begin, double end, unsigned int precision)
 {
-    const int divisor = power(10, (precision > 20) ? 20 : precision);
-    int i_begin = static_cast<int>(begin * divisor);
-    int i_end = static_cast<int>(end * divisor);
-    return random(i_begin, i_end) / static_cast<double>(divisor);
+    const int64_t divisor = power(int64_t{10}, (precision > 15) ? 15 : precision);
+    double const scaled_begin = begin * divisor;
+    double const scaled_end = end * divisor;
+    // the grid indices and their difference must fit in int64_t; beyond that (or for NaN) the grid
+    // is finer than the doubles around the bounds anyway
+    double const limit = 0x1.0p62;
+    if (!(std::abs(scaled_begin) < limit && std::abs(scaled_end) < limit)) {
+        return begin + (end - begin) * thread_rng().uniform();
+    }
+    int64_t const i_begin = static_cast<int64_t>(scaled_begin);
+    int64_t const i_end = static_cast<int64_t>(scaled_end);
+    uint64_t const range = static_cast<uint64_t>(i_end - i_begin) + 1;
+    return (i_begin + static_cast<int64_t>(thread_rng().bounded64(range))) / static_cast<double>(divisor);
 }
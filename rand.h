@@ -1,9 +1,70 @@
 #ifndef RAND_H
 #define RAND_H
 #include <stddef.h>
+#include <array>
+#include <cstdint>
+
+// xoshiro256** generator, satisfies UniformRandomBitGenerator
+class rng {
+public:
+    using result_type = uint64_t;
+
+    explicit rng(uint64_t seed = 0) noexcept;
+
+    // state is expanded from seed by splitmix64
+    void seed(uint64_t seed) noexcept;
+
+    uint64_t operator()() noexcept;
+
+    // unbiased value from [0, range), range == 0 means the full 32-bit range (Lemire)
+    uint32_t bounded(uint32_t range) noexcept;
+
+    // unbiased value from [0, range), range == 0 means the full 64-bit range
+    uint64_t bounded64(uint64_t range) noexcept;
+
+    // uniform in [0, 1)
+    double uniform() noexcept;
+
+    // advance by 2^128 steps: gives a non-overlapping stream for another worker
+    void jump() noexcept;
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return UINT64_MAX; }
+
+private:
+    uint64_t s[4];
+};
+
+// Philox4x32-10 counter-based generator: four words that depend only on (seed, step, lane, block),
+// with no state, so any sample can be computed on any thread and replayed; block extends the counter
+// when one call's 128 bits aren't enough
+std::array<uint32_t, 4> philox(uint64_t seed, uint32_t step, uint64_t lane, uint32_t block = 0) noexcept;
+
+// unbiased value from [0, range) for (seed, step, lane), range > 0
+uint32_t philox_bounded(uint64_t seed, uint32_t step, uint64_t lane, uint32_t range) noexcept;
+
+// same for ranges past 32 bits, from pairs of words
+uint64_t philox_bounded64(uint64_t seed, uint32_t step, uint64_t lane, uint64_t range) noexcept;
+
+// uniform in [0, 1) from 53 bits of two words
+inline double to_unit(uint32_t hi, uint32_t lo) noexcept {
+    return ((static_cast<uint64_t>(hi) << 21) ^ (lo >> 11)) * 0x1.0p-53;
+}
+
+// generator of the calling thread, seeded from the global seed and thread index;
+// for runs that must be reproducible across threads pass an explicit rng instead
+rng& thread_rng();
+
+// reseed every thread generator (lazily, on its next use); unset means std::random_device.
+// A seed reproduces the draws of thread_rng only when one thread draws: streams are numbered
+// in the order threads first call thread_rng, which changes from run to run with several threads.
+// Parallel work derives its numbers from a seed and an index instead (philox)
+void set_seed(uint64_t seed);
 
 int random(int begin, int end);
 
+// value from [begin, end] on a grid with step 10^-precision (precision is capped at 15);
+// uniform off the grid when the bounds over the step exceed 2^62
 double random(double begin, double end, unsigned int precision);
 
 #endif // RAND_H
@@ -0,0 +1,148 @@
+#include "replot_scheduler.h"
+#include <algorithm>
+#include <cmath>
+
+// quiet time after the last frame before full quality is restored
+static int const idle_ms = 300;
+// reduced frames in a row under half the budget that restore full quality while the plot keeps
+// changing; the margin leaves room for the antialiasing they are drawn without
+static int const restore_frames = 30;
+
+replot_scheduler::replot_scheduler(QCustomPlot* plot, int fps)
+    : QObject(plot), plot(plot), budget_ms(1000.0 / std::max(1, fps))
+{
+    frame_timer.setSingleShot(true);
+    frame_timer.setTimerType(Qt::PreciseTimer);
+    connect(&frame_timer, &QTimer::timeout, this, &replot_scheduler::flush);
+    idle_timer.setSingleShot(true);
+    idle_timer.setInterval(idle_ms);
+    connect(&idle_timer, &QTimer::timeout, this, &replot_scheduler::restore);
+    // every full replot is measured, those of mouse interactions included
+    connect(plot, &QCustomPlot::afterReplot, this, [this] { frame_done(this->plot->replotTime()); });
+}
+
+replot_scheduler* replot_scheduler::of(QCustomPlot* plot)
+{
+    return plot->findChild<replot_scheduler*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void replot_scheduler::invalidate(QCPLayer* layer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (layer) {
+        if (std::find(layers.begin(), layers.end(), layer) == layers.end()) {
+            layers.push_back(layer);
+        }
+    } else {
+        full = true;
+    }
+    if (!posted) {
+        posted = true;
+        QMetaObject::invokeMethod(this, [this] { flush(); }, Qt::QueuedConnection);
+    }
+}
+
+void replot_scheduler::flush()
+{
+    // too early for the next frame: requests keep merging until it is due
+    if (last_frame.isValid()) {
+        double const wait_ms = budget_ms - last_frame.nsecsElapsed() * 1e-6;
+        if (wait_ms > 0) {
+            frame_timer.start(static_cast<int>(std::ceil(wait_ms)));
+            return;
+        }
+    }
+
+    bool replot_all;
+    v<QCPLayer*> dirty;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        posted = false;
+        replot_all = full;
+        full = false;
+        dirty.swap(layers);
+    }
+    last_frame.start();
+
+    // layers may have been removed since they were invalidated
+    v<QCPLayer*> valid;
+    for (int i = 0; i < plot->layerCount(); ++i) {
+        if (std::find(dirty.begin(), dirty.end(), plot->layer(i)) != dirty.end()) {
+            valid.push_back(plot->layer(i));
+            // a layer without its own buffer is repainted with the whole plot anyway
+            replot_all = replot_all || plot->layer(i)->mode() != QCPLayer::lmBuffered;
+        }
+    }
+    if (replot_all) {
+        plot->replot();
+        return;
+    }
+    if (valid.empty()) {
+        return;
+    }
+    // falls back to a full replot by itself while the paint buffers are invalid, e.g. after a resize
+    QElapsedTimer timer;
+    timer.start();
+    for (QCPLayer* layer : valid) {
+        layer->replot();
+    }
+    frame_done(timer.nsecsElapsed() * 1e-6);
+}
+
+void replot_scheduler::frame_done(double ms)
+{
+    if (restoring) {
+        return;
+    }
+    if (ms > budget_ms) {
+        set_reduced(true);
+    }
+    fast_frames = ms < budget_ms / 2 ? fast_frames + 1 : 0;
+    if (is_reduced && fast_frames == restore_frames) {
+        // queued: called from afterReplot, the replot of restore() would be ignored
+        QMetaObject::invokeMethod(this, [this] { restore(); }, Qt::QueuedConnection);
+    }
+    idle_timer.start();
+}
+
+void replot_scheduler::set_reduced(bool reduced)
+{
+    if (reduced == is_reduced) {
+        return;
+    }
+    is_reduced = reduced;
+    fast_frames = 0;
+    if (reduced) {
+        antialiased = plot->antialiasedElements();
+        not_antialiased = plot->notAntialiasedElements();
+        plot->setNotAntialiasedElements(QCP::aeAll);
+    } else {
+        plot->setNotAntialiasedElements(not_antialiased);
+        plot->setAntialiasedElements(antialiased);
+    }
+    emit quality_changed(reduced);
+}
+
+void replot_scheduler::restore()
+{
+    if (!is_reduced) {
+        return;
+    }
+    set_reduced(false);
+    // one full quality frame, which mustn't count as slow activity and reduce quality again
+    restoring = true;
+    plot->replot();
+    restoring = false;
+    last_frame.start();
+}
+
+void request_replot(QCustomPlot* plot, QCPLayer* layer)
+{
+    if (replot_scheduler* scheduler = replot_scheduler::of(plot)) {
+        scheduler->invalidate(layer);
+    } else if (layer) {
+        layer->replot();
+    } else {
+        plot->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef REPLOT_SCHEDULER_H
+#define REPLOT_SCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <mutex>
+#include "qcustomplot.h"
+#include "algos.h"
+
+// merges repaint requests for a plot into at most one replot per frame. A frame that takes longer
+// than its budget switches the plot to reduced quality: no antialiasing, and quality_changed tells
+// owners of curves to use coarser levels of detail. Full quality returns once the plot is idle,
+// or while it keeps changing once enough frames in a row are fast
+class replot_scheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit replot_scheduler(QCustomPlot* plot, int fps = 60);
+
+    // thread-safe: repaint `layer` (only its buffer if it is lmBuffered) or, with nullptr, the whole plot
+    // in the next frame
+    void invalidate(QCPLayer* layer = nullptr);
+
+    bool reduced() const {
+        return is_reduced;
+    }
+
+    // the scheduler of a plot, nullptr if it has none
+    static replot_scheduler* of(QCustomPlot* plot);
+
+signals:
+    void quality_changed(bool reduced);
+
+private:
+    void flush();
+    void frame_done(double ms);
+    void set_reduced(bool reduced);
+    void restore();
+
+    QCustomPlot* plot;
+    double const budget_ms;
+    QElapsedTimer last_frame;
+    QTimer frame_timer;
+    QTimer idle_timer;
+    bool is_reduced = false;
+    bool restoring = false;
+    int fast_frames = 0;
+    QCP::AntialiasedElements antialiased;
+    QCP::AntialiasedElements not_antialiased;
+
+    std::mutex mutex;
+    bool posted = false;
+    bool full = false;
+    v<QCPLayer*> layers;
+};
+
+// from the GUI thread: through the scheduler of the plot if it has one, otherwise right away
+// for a layer and queued for the whole plot
+void request_replot(QCustomPlot* plot, QCPLayer* layer = nullptr);
+
+#endif // REPLOT_SCHEDULER_H
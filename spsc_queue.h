@@ -0,0 +1,62 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread;
+// capacity is rounded up to a power of two
+template<typename T>
+class spsc_queue {
+public:
+    explicit spsc_queue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask = size - 1;
+        items = std::make_unique<T[]>(size);
+    }
+
+    spsc_queue(spsc_queue const&) = delete;
+    spsc_queue& operator=(spsc_queue const&) = delete;
+
+    // producer side; false if the queue is full
+    bool try_push(T const& value) {
+        size_t const t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache > mask) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache > mask) {
+                return false;
+            }
+        }
+        items[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side; false if the queue is empty
+    bool try_pop(T& value) {
+        size_t const h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) {
+                return false;
+            }
+        }
+        value = std::move(items[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // producer and consumer indices on separate cache lines, each with a cached copy of the other one
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t head_cache = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    size_t tail_cache = 0;
+    alignas(64) size_t mask;
+    std::unique_ptr<T[]> items;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,134 @@
+#include "surface_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include "parallel.h"
+
+// keeps the tile counts of a level, and their product, far from overflowing;
+// the byte offsets are checked as they are summed
+static uint64_t const max_samples = uint64_t{1} << 31;
+
+v<surface_level> surface_levels(surface_header const& header, uint64_t const max_size)
+{
+    v<surface_level> result;
+    if (max_size < sizeof(surface_header) || header.width == 0 || header.height == 0 || header.tile == 0
+            || header.width > max_samples || header.height > max_samples || header.tile > (1u << 14)
+            || !(header.x_min < header.x_max) || !(header.y_min < header.y_max)) {
+        return result;
+    }
+
+    uint64_t const tile_bytes = uint64_t{header.tile} * header.tile * sizeof(float);
+    uint64_t offset = sizeof(surface_header);
+    for (int l = 0; ; ++l) {
+        surface_level level;
+        level.width = (header.width + (uint64_t{1} << l) - 1) >> l;
+        level.height = (header.height + (uint64_t{1} << l) - 1) >> l;
+        level.tiles_x = (level.width + header.tile - 1) / header.tile;
+        level.tiles_y = (level.height + header.tile - 1) / header.tile;
+        level.offset = offset;
+        level.step_x = std::ldexp((header.x_max - header.x_min) / static_cast<double>(header.width), l);
+        level.step_y = std::ldexp((header.y_max - header.y_min) / static_cast<double>(header.height), l);
+        // offset + tiles * tile_bytes <= max_size, without overflowing on the way
+        uint64_t const tiles = level.tiles_x * level.tiles_y;
+        if (tiles > (max_size - offset) / tile_bytes) {
+            return {};
+        }
+        result.push_back(level);
+        offset += tiles * tile_bytes;
+        if (level.tiles_x == 1 && level.tiles_y == 1) {
+            break;
+        }
+    }
+    return result;
+}
+
+uint64_t surface_size(surface_header const& header, v<surface_level> const& levels)
+{
+    if (levels.empty()) {
+        return sizeof(surface_header);
+    }
+    surface_level const& last = levels.back();
+    return last.offset + last.tiles_x * last.tiles_y * uint64_t{header.tile} * header.tile * sizeof(float);
+}
+
+bool surface_valid(surface_header const& header, uint64_t file_size)
+{
+    if (file_size < sizeof(surface_header) || std::memcmp(header.magic, surface_header{}.magic, sizeof(header.magic)) != 0) {
+        return false;
+    }
+    auto const levels = surface_levels(header, file_size);
+    return !levels.empty() && header.levels == levels.size();
+}
+
+bool write_surface(std::string const& path, surface_header header,
+                   std::function<double(double, double)> const& f, unsigned threads)
+{
+    auto const levels = surface_levels(header);
+    if (levels.empty()) {
+        return false;
+    }
+    header.levels = static_cast<uint32_t>(levels.size());
+
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout) {
+        return false;
+    }
+    // rewritten with the bounds once all samples are known
+    fout.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    size_t const n = header.tile;
+    double lower = std::numeric_limits<double>::infinity();
+    double upper = -std::numeric_limits<double>::infinity();
+    for (size_t l = 0; l < levels.size(); ++l) {
+        surface_level const& level = levels[l];
+        // one row of tiles at a time, at most tile rows of the surface in memory
+        v<float> row(level.tiles_x * n * n);
+        v<pr<double, double>> bounds(level.tiles_x);
+        for (uint64_t ty = 0; ty < level.tiles_y; ++ty) {
+            parallel_for(level.tiles_x, [&](size_t const tx) {
+                float* out = row.data() + tx * n * n;
+                double low = std::numeric_limits<double>::infinity();
+                double high = -std::numeric_limits<double>::infinity();
+                for (size_t j = 0; j < n; ++j) {
+                    uint64_t const y = ty * n + j;
+                    double const b = header.y_min + (static_cast<double>(y) + 0.5) * level.step_y;
+                    for (size_t i = 0; i < n; ++i, ++out) {
+                        uint64_t const x = tx * n + i;
+                        if (x >= level.width || y >= level.height) {
+                            *out = std::numeric_limits<float>::quiet_NaN();
+                            continue;
+                        }
+                        double const z = f(header.x_min + (static_cast<double>(x) + 0.5) * level.step_x, b);
+                        *out = static_cast<float>(z);
+                        if (std::isfinite(z)) {
+                            low = std::min(low, z);
+                            high = std::max(high, z);
+                        }
+                    }
+                }
+                bounds[tx] = {low, high};
+            }, threads);
+
+            if (l == 0) {
+                for (auto const& elem : bounds) {
+                    lower = std::min(lower, elem.first);
+                    upper = std::max(upper, elem.second);
+                }
+            }
+            fout.write(reinterpret_cast<char const*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)));
+            if (!fout) {
+                return false;
+            }
+        }
+    }
+
+    if (lower <= upper) {
+        header.lower = lower;
+        header.upper = upper;
+    }
+    fout.seekp(0);
+    fout.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    return static_cast<bool>(fout.flush());
+}
@@ -0,0 +1,53 @@
+#ifndef SURFACE_FILE_H
+#define SURFACE_FILE_H
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "algos.h"
+
+// binary surface file: the header, then the tiles of every level from full resolution down to
+// a single tile. Tiles of a level are row-major, samples in a tile row-major with x running fastest;
+// samples are float in native byte order, padding past the edge of a level is NaN.
+// A cell of level l covers 2^l x 2^l cells of level 0, samples lie in the centers of their cells
+struct surface_header {
+    char magic[8] = {'S', 'U', 'R', 'F', 'A', 'C', 'E', '1'};
+    uint64_t width = 0;  // samples of level 0
+    uint64_t height = 0;
+    uint32_t tile = 256; // samples per tile side
+    uint32_t levels = 0;
+    // extent of the cells of level 0
+    double x_min = 0;
+    double x_max = 0;
+    double y_min = 0;
+    double y_max = 0;
+    // bounds of the finite samples of level 0
+    double lower = 0;
+    double upper = 0;
+};
+
+struct surface_level {
+    uint64_t width;
+    uint64_t height;
+    uint64_t tiles_x;
+    uint64_t tiles_y;
+    uint64_t offset; // of the first tile, from the start of the file
+    double step_x;   // cell size
+    double step_y;
+};
+
+// levels of a header with width, height, tile and extent set; empty if they are invalid
+// or a file holding them would be larger than max_size bytes
+v<surface_level> surface_levels(surface_header const& header, uint64_t max_size = UINT64_MAX);
+
+// bytes of a file with these levels
+uint64_t surface_size(surface_header const& header, v<surface_level> const& levels);
+
+// magic, sizes and extent of a header read from a file of file_size bytes
+bool surface_valid(surface_header const& header, uint64_t file_size);
+
+// samples f at the cell centers of every level, tile rows in parallel, and writes the file;
+// levels and bounds of the header are filled in. False if the header is invalid or writing fails
+bool write_surface(std::string const& path, surface_header header,
+                   std::function<double(double, double)> const& f, unsigned threads = 0);
+
+#endif // SURFACE_FILE_H
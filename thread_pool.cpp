@@ -0,0 +1,95 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+thread_pool::thread_pool(unsigned threads)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&thread_pool::run, this);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& elem : workers) {
+        elem.join();
+    }
+}
+
+void thread_pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+thread_pool& thread_pool::global()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+void thread_pool::run()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+task_group::task_group(thread_pool& pool) : pool(pool) {}
+
+task_group::~task_group()
+{
+    cancel();
+    wait();
+}
+
+void task_group::submit(std::function<void()> task, std::function<void()> skipped)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++pending;
+    }
+    pool.submit([this, task = std::move(task), skipped = std::move(skipped)] {
+        if (!cancelled()) {
+            task();
+        } else if (skipped) {
+            skipped();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            cv.notify_all();
+        }
+    });
+}
+
+void task_group::cancel() noexcept
+{
+    stopped.store(true, std::memory_order_relaxed);
+}
+
+void task_group::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return pending == 0; });
+}
@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads executing submitted tasks in FIFO order
+class thread_pool {
+public:
+    // threads == 0 means hardware concurrency
+    explicit thread_pool(unsigned threads = 0);
+
+    // finishes queued tasks, then joins the workers
+    ~thread_pool();
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    void submit(std::function<void()> task);
+
+    unsigned size() const noexcept {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    // shared pool used by parallel_for and background jobs
+    static thread_pool& global();
+
+private:
+    void run();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+// tasks submitted to a pool on behalf of one owner: the owner can cancel them and wait until none runs;
+// long tasks should poll cancelled() themselves
+class task_group {
+public:
+    explicit task_group(thread_pool& pool = thread_pool::global());
+
+    // cancels and waits
+    ~task_group();
+
+    task_group(task_group const&) = delete;
+    task_group& operator=(task_group const&) = delete;
+
+    // tasks that haven't started when the group is cancelled are skipped, running skipped instead if given
+    void submit(std::function<void()> task, std::function<void()> skipped = {});
+
+    void cancel() noexcept;
+
+    bool cancelled() const noexcept {
+        return stopped.load(std::memory_order_relaxed);
+    }
+
+    void wait();
+
+private:
+    thread_pool& pool;
+    std::atomic<bool> stopped{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending = 0;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,80 @@
+#include "tile_cache.h"
+#include <algorithm>
+
+size_t tile_key_hash::operator()(tile_key const& key) const noexcept
+{
+    uint64_t h = static_cast<uint64_t>(key.level) * 0x9e3779b97f4a7c15;
+    h ^= static_cast<uint64_t>(key.tx) + 0xbf58476d1ce4e5b9 + (h << 6) + (h >> 2);
+    h ^= static_cast<uint64_t>(key.ty) + 0x94d049bb133111eb + (h << 6) + (h >> 2);
+    return static_cast<size_t>(h);
+}
+
+int tile_grid::level_for(double units_per_pixel) const
+{
+    return static_cast<int>(std::lround(std::log2(base / samples / units_per_pixel)));
+}
+
+tile_t compute_tile(tile_grid const& grid, tile_key const& key, std::function<double(double, double)> const& f)
+{
+    auto tile = std::make_shared<std::vector<double>>(static_cast<size_t>(grid.samples) * grid.samples);
+    double* out = tile->data();
+
+    for (int j = 0; j < grid.samples; ++j) {
+        double const y = grid.coord(key.level, key.ty, j);
+        for (int i = 0; i < grid.samples; ++i) {
+            *out++ = f(grid.coord(key.level, key.tx, i), y);
+        }
+    }
+    return tile;
+}
+
+tile_cache::tile_cache(size_t budget_bytes) : budget_bytes(budget_bytes) {}
+
+tile_t tile_cache::find(tile_key const& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return nullptr;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+}
+
+void tile_cache::insert(tile_key const& key, tile_t tile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        used_bytes -= it->second->second->size() * sizeof(double);
+        lru.erase(it->second);
+    }
+    used_bytes += tile->size() * sizeof(double);
+    lru.emplace_front(key, std::move(tile));
+    index[key] = lru.begin();
+    evict();
+}
+
+void tile_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    index.clear();
+    used_bytes = 0;
+}
+
+size_t tile_cache::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return used_bytes;
+}
+
+void tile_cache::evict()
+{
+    // the newest tile always stays, even if it alone exceeds the budget
+    while (used_bytes > budget_bytes && lru.size() > 1) {
+        used_bytes -= lru.back().second->size() * sizeof(double);
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// tile `tx, ty` of level `level`; levels may be negative for zoomed out views
+struct tile_key {
+    int level;
+    int64_t tx;
+    int64_t ty;
+
+    bool operator==(tile_key const&) const = default;
+};
+
+struct tile_key_hash {
+    size_t operator()(tile_key const& key) const noexcept;
+};
+
+// square tiles of samples x samples values, a tile of level l covers base / 2^l world units per side;
+// samples are centered in their cells, row-major with x running fastest
+struct tile_grid {
+    double base = 16;
+    int samples = 128;
+
+    double size(int const level) const {
+        return std::ldexp(base, -level);
+    }
+
+    double step(int const level) const {
+        return size(level) / samples;
+    }
+
+    // world coordinate of sample i of tile t
+    double coord(int const level, int64_t const t, int const i) const {
+        return (static_cast<double>(t) * samples + i + 0.5) * step(level);
+    }
+
+    int64_t tile_of(int const level, double const coord) const {
+        return static_cast<int64_t>(std::floor(coord / size(level)));
+    }
+
+    // level whose sample step is closest to units_per_pixel
+    int level_for(double units_per_pixel) const;
+};
+
+using tile_t = std::shared_ptr<std::vector<double> const>;
+
+tile_t compute_tile(tile_grid const& grid, tile_key const& key, std::function<double(double, double)> const& f);
+
+// thread-safe LRU cache of tiles bounded by memory
+class tile_cache {
+public:
+    explicit tile_cache(size_t budget_bytes);
+
+    // nullptr if missing; a hit becomes the most recently used tile
+    tile_t find(tile_key const& key);
+
+    // evicts least recently used tiles while over budget
+    void insert(tile_key const& key, tile_t tile);
+
+    void clear();
+
+    size_t bytes() const;
+
+private:
+    void evict();
+
+    using entry_t = std::pair<tile_key, tile_t>;
+
+    size_t const budget_bytes;
+    size_t used_bytes = 0;
+    std::list<entry_t> lru;
+    std::unordered_map<tile_key, std::list<entry_t>::iterator, tile_key_hash> index;
+    mutable std::mutex mutex;
+};
+
+#endif // TILE_CACHE_H
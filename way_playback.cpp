@@ -0,0 +1,99 @@
+#include "way_playback.h"
+#include <algorithm>
+
+way_playback::way_playback(QCPLayer* layer, double steps_per_second, int fps)
+    : QObject(layer), layer(layer), speed(steps_per_second)
+{
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(1000 / std::max(1, fps));
+    connect(&timer, &QTimer::timeout, this, &way_playback::frame);
+}
+
+void way_playback::add(std::shared_ptr<way_pyramid const> way, QPen const& pen)
+{
+    if (!layer || way->full().empty()) {
+        return;
+    }
+    QCPItemTracer* tracer = new QCPItemTracer(layer->parentPlot());
+    tracer->setLayer(layer);
+    tracer->setStyle(QCPItemTracer::tsCircle);
+    tracer->setSize(9);
+    tracer->setPen(QPen(pen.color().darker(), 1.5));
+    tracer->setBrush(pen.color());
+    tracer->setSelectable(false);
+    tracer->setVisible(running());
+    tracks.push_back({std::move(way), tracer});
+    if (running()) {
+        frame();
+    }
+}
+
+void way_playback::set_steps_per_second(double steps_per_second)
+{
+    if (running()) {
+        step_offset = step();
+        clock.restart();
+    }
+    speed = steps_per_second;
+}
+
+void way_playback::start()
+{
+    step_offset = 0;
+    clock.start();
+    for (auto const& elem : tracks) {
+        if (elem.tracer) {
+            elem.tracer->setVisible(true);
+        }
+    }
+    timer.start();
+    frame();
+}
+
+void way_playback::stop()
+{
+    timer.stop();
+}
+
+double way_playback::step() const
+{
+    return step_offset + clock.nsecsElapsed() * 1e-9 * speed;
+}
+
+void way_playback::frame()
+{
+    if (!layer) {
+        timer.stop();
+        return;
+    }
+    double const now = step();
+    bool finished = true;
+    for (auto const& elem : tracks) {
+        if (!elem.tracer) {
+            continue;
+        }
+        v<way_point> const& way = elem.way->full();
+        // first point after the current step: a binary search, so a million steps cost nothing per frame
+        auto next = std::upper_bound(way.begin(), way.end(), now, [](double const t, way_point const& point) {
+            return t < point.t;
+        });
+        QPointF position;
+        if (next == way.end()) {
+            position = {way.back().k, way.back().b};
+        } else if (next == way.begin()) {
+            position = {next->k, next->b};
+            finished = false;
+        } else {
+            // between two recorded steps when playing slower than one step per frame
+            auto const prev = next - 1;
+            double const f = next->t > prev->t ? (now - prev->t) / (next->t - prev->t) : 0;
+            position = {prev->k + f * (next->k - prev->k), prev->b + f * (next->b - prev->b)};
+            finished = false;
+        }
+        elem.tracer->position->setCoords(position);
+    }
+    request_replot(layer->parentPlot(), layer);
+    if (finished) {
+        timer.stop();
+    }
+}
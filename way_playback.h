@@ -0,0 +1,54 @@
+#ifndef WAY_PLAYBACK_H
+#define WAY_PLAYBACK_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <memory>
+#include "qcustomplot.h"
+#include "decimate.h"
+#include "replot_scheduler.h"
+
+// moves a QCPItemTracer per way along its full trajectory, all at the same rate in optimizer steps
+// per second of wall-clock time; tracers live on one buffered layer, which alone is repainted every frame
+class way_playback : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit way_playback(QCPLayer* layer, double steps_per_second = 250, int fps = 60);
+
+    void add(std::shared_ptr<way_pyramid const> way, QPen const& pen);
+    // keeps the current step, so the speed can change while playing
+    void set_steps_per_second(double steps_per_second);
+    double steps_per_second() const {
+        return speed;
+    }
+
+    // from step 0
+    void start();
+    void stop();
+    bool running() const {
+        return timer.isActive();
+    }
+
+private:
+    void frame();
+    double step() const;
+
+    struct track {
+        std::shared_ptr<way_pyramid const> way;
+        QPointer<QCPItemTracer> tracer;
+    };
+
+    QPointer<QCPLayer> layer;
+    v<track> tracks;
+    double speed;
+    // step at the moment the clock was started
+    double step_offset = 0;
+    QElapsedTimer clock;
+    QTimer timer;
+};
+
+#endif // WAY_PLAYBACK_H